@@ -29,7 +29,10 @@
 #include "mythos/protocol/CpuDriverKNC.hh"
 #include "mythos/PciMsgQueueMPSC.hh"
 #include "mythos/InfoFrame.hh"
+#include "mythos/PmuSamples.hh"
 #include "runtime/Portal.hh"
+#include "runtime/PortalPool.hh"
+#include "runtime/EventLoop.hh"
 #include "runtime/ExecutionContext.hh"
 #include "runtime/CapMap.hh"
 #include "runtime/RaplDriverIntel.hh"
@@ -53,8 +56,10 @@
 #include <array>
 #include <math.h> 
 #include <iostream>
+#include <string>
 
 #include <pthread.h>
+#include <omp.h>
 #include "runtime/thread-extra.hh"
 #include <sys/time.h>
 
@@ -63,6 +68,7 @@ mythos::InfoFrame* info_ptr asm("info_ptr");
 int main() asm("main");
 
 extern char process_test_image_start SYMBOL("process_test_image_start");
+extern char process_test_image_end SYMBOL("process_test_image_end");
 
 constexpr uint64_t stacksize = 4*4096;
 char initstack[stacksize];
@@ -135,6 +141,28 @@ void test_Portal()
   MLOG_ERROR(mlog::app, "test_Portal end");
 }
 
+void test_EventLoop()
+{
+  MLOG_ERROR(mlog::app, "test_EventLoop begin");
+  mythos::PortalLock pl(portal);
+  // a second portal owned by this thread, thus two invocations can be in flight
+  auto p2 = mythos::portalPool.assign(pl, mythos::init::EC);
+  TEST(p2 != nullptr);
+  mythos::Frame f1(capAlloc());
+  mythos::Frame f2(capAlloc());
+  mythos::Tasklet t1, t2;
+  mythos::EventLoop loop;
+  auto res1 = f1.create(pl, kmem, 2*1024*1024, 2*1024*1024);
+  auto res2 = f2.create(mythos::PortalLock(*p2), kmem, 2*1024*1024, 2*1024*1024);
+  loop.then(res1, t1, [](mythos::optional<void> res) { TEST(res); });
+  loop.then(res2, t2, [](mythos::optional<void> res) { TEST(res); });
+  loop.run();
+  TEST(capAlloc.free(f1, pl));
+  TEST(capAlloc.free(f2, pl));
+  mythos::portalPool.release(pl, *p2);
+  MLOG_ERROR(mlog::app, "test_EventLoop end");
+}
+
 void test_float()
 {
   MLOG_INFO(mlog::app, "testing user-mode floating point");
@@ -316,6 +344,165 @@ void* thread_main(void* ctx)
   return 0;
 }
 
+void* affinityMain(void* arg){
+  size_t cpu = size_t(arg);
+  // live floating point state has to move along with the thread
+  double x = 1.5;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  TEST_EQ(sched_setaffinity(0, sizeof(set), &set), 0);
+  x *= 2.0;
+  TEST_EQ(x, 3.0);
+  CPU_ZERO(&set);
+  sched_getaffinity(0, sizeof(set), &set);
+  TEST(CPU_ISSET(cpu, &set));
+  TEST_EQ(CPU_COUNT(&set), 1);
+  MLOG_INFO(mlog::app, "Thread migrated", DVAR(cpu));
+  return 0;
+}
+
+void test_affinity(){
+  MLOG_INFO(mlog::app, "Test affinity");
+  pthread_t p;
+  auto cpu = info_ptr->getNumThreads()-1;
+  TEST_EQ(pthread_create(&p, NULL, &affinityMain, (void*) size_t(cpu)), 0);
+  pthread_join(p, NULL);
+  MLOG_INFO(mlog::app, "End Test affinity");
+}
+
+void* logRingMain(void* arg){
+  for (int i = 0; i < 100; i++) std::cout << "log ring thread " << size_t(arg) << " line " << i << std::endl;
+  return 0;
+}
+
+void test_log_ring(){
+  MLOG_INFO(mlog::app, "Test log ring");
+  pthread_t p[4];
+  for (size_t i = 0; i < 4; i++) TEST_EQ(pthread_create(&p[i], NULL, &logRingMain, (void*) i), 0);
+  for (size_t i = 0; i < 4; i++) pthread_join(p[i], NULL);
+  // longer than a record and than the kernel's copy buffer, must not be truncated
+  std::string line(mythos::LogRing::MAX_TEXT + 1000, 'x');
+  line.back() = '\n';
+  mlog::sink->write(line.data(), line.size());
+  // a drain stops early while another core drains or a record is still being written
+  auto ring = info_ptr->getLogRing();
+  for (int i = 0; i < 1000 && ring->fill() != 0; i++) mlog::sink->flush();
+  TEST_EQ(ring->fill(), 0u);
+  MLOG_INFO(mlog::app, "End Test log ring");
+}
+
+struct SyncBench {
+  static constexpr unsigned ROUNDS = 1000;
+  pthread_barrier_t barrier;
+  pthread_spinlock_t spin;
+  pthread_rwlock_t rwlock;
+  uint64_t counter = 0;
+  timeval time[4];
+};
+
+double seconds(timeval const& start, timeval const& end) {
+  return (end.tv_usec - start.tv_usec)/1000000.0 + end.tv_sec - start.tv_sec;
+}
+
+void* syncBenchMain(void* arg){
+  auto b = static_cast<SyncBench*>(arg);
+  // the serial thread of each phase takes the time stamp
+  if (pthread_barrier_wait(&b->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) gettimeofday(&b->time[0], 0);
+  for (unsigned i = 0; i < SyncBench::ROUNDS; i++) pthread_barrier_wait(&b->barrier);
+  if (pthread_barrier_wait(&b->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) gettimeofday(&b->time[1], 0);
+  for (unsigned i = 0; i < SyncBench::ROUNDS; i++) {
+    pthread_spin_lock(&b->spin);
+    b->counter++;
+    pthread_spin_unlock(&b->spin);
+  }
+  if (pthread_barrier_wait(&b->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) gettimeofday(&b->time[2], 0);
+  uint64_t sum = 0;
+  for (unsigned i = 0; i < SyncBench::ROUNDS; i++) {
+    if (i % 100 == 0) {
+      pthread_rwlock_wrlock(&b->rwlock);
+      b->counter++;
+      pthread_rwlock_unlock(&b->rwlock);
+    } else {
+      pthread_rwlock_rdlock(&b->rwlock);
+      sum += b->counter;
+      pthread_rwlock_unlock(&b->rwlock);
+    }
+  }
+  if (pthread_barrier_wait(&b->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) gettimeofday(&b->time[3], 0);
+  return (void*) sum;
+}
+
+void test_pthread_sync(){
+  MLOG_INFO(mlog::app, "Test pthread synchronization");
+  // every thread needs its own hardware thread, the main thread takes part as well
+  for (unsigned n = 2; n <= 256 && n <= info_ptr->getNumThreads(); n *= 2) {
+    SyncBench b;
+    TEST_EQ(pthread_barrier_init(&b.barrier, NULL, n), 0);
+    TEST_EQ(pthread_spin_init(&b.spin, PTHREAD_PROCESS_PRIVATE), 0);
+    TEST_EQ(pthread_rwlock_init(&b.rwlock, NULL), 0);
+    std::vector<pthread_t> threads(n-1);
+    for (auto& t : threads) TEST_EQ(pthread_create(&t, NULL, &syncBenchMain, &b), 0);
+    syncBenchMain(&b);
+    for (auto& t : threads) pthread_join(t, NULL);
+    TEST_EQ(b.counter, uint64_t(n) * (SyncBench::ROUNDS + SyncBench::ROUNDS/100));
+    std::cout << n << " threads: barrier " << 1e6*seconds(b.time[0], b.time[1])/SyncBench::ROUNDS
+      << " us, spinlock " << 1e6*seconds(b.time[1], b.time[2])/SyncBench::ROUNDS
+      << " us, rwlock " << 1e6*seconds(b.time[2], b.time[3])/SyncBench::ROUNDS
+      << " us per round" << std::endl;
+    pthread_rwlock_destroy(&b.rwlock);
+    pthread_spin_destroy(&b.spin);
+    pthread_barrier_destroy(&b.barrier);
+  }
+  MLOG_INFO(mlog::app, "End Test pthread synchronization");
+}
+
+uint64_t ompFib(unsigned n) {
+  if (n < 2) return n;
+  uint64_t a, b;
+  #pragma omp task shared(a)
+  a = ompFib(n-1);
+  #pragma omp task shared(b)
+  b = ompFib(n-2);
+  #pragma omp taskwait
+  return a + b;
+}
+
+void test_omp(){
+  MLOG_INFO(mlog::app, "Test OpenMP");
+  // the workers keep their scheduling contexts, leave some for the other tests
+  omp_set_num_threads(2);
+  timeval start, end;
+  // the first region creates the team, the second one reuses it
+  for (int round = 0; round < 2; round++) {
+    std::atomic<int> members = {0};
+    gettimeofday(&start, 0);
+    #pragma omp parallel
+    members++;
+    gettimeofday(&end, 0);
+    TEST(members.load() >= 1 && members.load() <= omp_get_max_threads());
+    std::cout << "parallel region with " << members.load() << " threads took "
+      << 1e6*seconds(start, end) << " us" << std::endl;
+  }
+
+  uint64_t sum = 0;
+  #pragma omp parallel for reduction(+:sum) schedule(static)
+  for (int i = 0; i < 10000; i++) sum += i;
+  TEST_EQ(sum, 10000ul*9999/2);
+
+  sum = 0;
+  #pragma omp parallel for reduction(+:sum) schedule(dynamic, 7)
+  for (int i = 0; i < 10000; i++) sum += i;
+  TEST_EQ(sum, 10000ul*9999/2);
+
+  uint64_t fib = 0;
+  #pragma omp parallel
+  #pragma omp single
+  fib = ompFib(20);
+  TEST_EQ(fib, 6765ul);
+  MLOG_INFO(mlog::app, "End Test OpenMP");
+}
+
 void test_ExecutionContext()
 {
   MLOG_INFO(mlog::app, "Test ExecutionContext");
@@ -366,23 +553,121 @@ void test_ExecutionContext()
   MLOG_INFO(mlog::app, "End Test ExecutionContext");
 }
 
-void test_InterruptControl() {
-  MLOG_INFO(mlog::app, "test_InterruptControl start");
-  mythos::InterruptControl ic(mythos::init::INTERRUPT_CONTROL_START);
+struct FaultCatcher : public mythos::ISysretHandler, public mythos::FutureBase {
+  void sysret(uint64_t fault) override {
+    this->fault = fault;
+    FutureBase::assign(mythos::Error::SUCCESS);
+  }
+  uint64_t fault = 0;
+};
 
-  mythos::PortalLock pl(portal); // future access will fail if the portal is in use already
+void* pagerFaultMain(void* ctx) {
+  *static_cast<volatile size_t*>(ctx) = 42; // faults until the pager maps a frame
+  return 0;
+}
 
+void test_pager()
+{
+  MLOG_INFO(mlog::app, "Test pager");
+  typedef mythos::protocol::PageMap::MapFlags MapFlags;
+  mythos::PortalLock pl(portal);
+  uintptr_t vaddr = 4ul << 39;
+
+  // map the first page only, which creates the page maps for the second one
+  mythos::Frame f(capAlloc());
+  TEST(f.create(pl, kmem, 2*4096, 4096).wait());
+  mythos::protocol::PageMap::MmapMany batch(kmem.cap(), MapFlags().writable(true).configurable(true));
+  std::array<mythos::CapPtr, 3> tables = {{capAlloc(), capAlloc(), capAlloc()}};
+  for (auto t : tables) TEST(batch.addTable(t));
+  TEST(batch.add(f.cap(), vaddr, 4096, MapFlags().writable(true)));
+  TEST(myAS.mmapMany(pl, batch).wait());
+  auto lazy = vaddr + 4096;
+
+  FaultCatcher faults;
   mythos::ExecutionContext ec(capAlloc());
   auto tls = mythos::setupNewTLS();
   ASSERT(tls != nullptr);
   auto sc = pa.alloc(pl).wait();
   TEST(sc);
-  auto res1 = ec.create(kmem).as(myAS).cs(myCS).sched(sc->cap)
+  TEST(ec.create(kmem).as(myAS).cs(myCS).sched(sc->cap)
+       .prepareStack(thread2stack_top).startFun(&pagerFaultMain, (void*)lazy)
+       .suspended(true).fs(tls)
+       .invokeVia(pl).wait());
+  mythos::ISysretHandler* handler = &faults;
+  TEST(ec.setPager(pl, mythos_get_pthread_ec_self(), mythos::KEvent::Context(handler)).wait());
+  TEST(ec.resume(pl).wait());
+
+  faults.wait();
+  mythos::protocol::ExecutionContext::PageFault fault(faults.fault);
+  MLOG_INFO(mlog::app, "got page fault", DVARhex(fault.addr), DVARhex(fault.error));
+  TEST_EQ(fault.addr, lazy);
+  TEST(fault.write());
+  TEST(!fault.present());
+  TEST(ec.resolveFault(pl, myAS, f, lazy, 4096, MapFlags().writable(true), 4096).wait());
+  while (*reinterpret_cast<volatile size_t*>(lazy) != 42) {}
+
+  TEST(capAlloc.free(ec, pl));
+  TEST(capAlloc.free(f, pl));
+  for (auto t : tables) TEST(capAlloc.free(t, pl));
+  MLOG_INFO(mlog::app, "End Test pager");
+}
+
+void test_copyOnWrite()
+{
+  MLOG_INFO(mlog::app, "Test copy on write");
+  typedef mythos::protocol::PageMap::MapFlags MapFlags;
+  mythos::PortalLock pl(portal);
+  uintptr_t vaddr = 5ul << 39;
+
+  // the first page shares the frame with the second page until it is written
+  mythos::Frame f(capAlloc());
+  TEST(f.create(pl, kmem, 4096, 4096).wait());
+  mythos::Frame pool(capAlloc());
+  TEST(pool.create(pl, kmem, 4*4096, 4096).wait());
+  TEST(myAS.setCowPool(pl, pool).wait());
+  mythos::protocol::PageMap::MmapMany batch(kmem.cap(), MapFlags().writable(true).configurable(true));
+  std::array<mythos::CapPtr, 3> tables = {{capAlloc(), capAlloc(), capAlloc()}};
+  for (auto t : tables) TEST(batch.addTable(t));
+  TEST(batch.add(f.cap(), vaddr, 4096, MapFlags().writable(true).copy_on_write(true)));
+  TEST(batch.add(f.cap(), vaddr+4096, 4096, MapFlags().writable(true)));
+  TEST(myAS.mmapMany(pl, batch).wait());
+
+  auto cow = reinterpret_cast<volatile size_t*>(vaddr);
+  auto shared = reinterpret_cast<volatile size_t*>(vaddr+4096);
+  *shared = 23;
+  TEST_EQ(*cow, 23u);
+  *cow = 42; // the kernel copies the page and repeats the write
+  TEST_EQ(*cow, 42u);
+  TEST_EQ(*shared, 23u);
+
+  TEST(myAS.setCowPool(pl, mythos::Frame(mythos::null_cap)).wait());
+  TEST(capAlloc.free(pool, pl));
+  TEST(capAlloc.free(f, pl));
+  for (auto t : tables) TEST(capAlloc.free(t, pl));
+  MLOG_INFO(mlog::app, "End Test copy on write");
+}
+
+void test_InterruptControl() {
+  MLOG_INFO(mlog::app, "test_InterruptControl start");
+  mythos::InterruptControl ic(mythos::init::INTERRUPT_CONTROL_START);
+
+  mythos::PortalLock pl(portal); // future access will fail if the portal is in use already
+
+  // the listener has no scheduling context, the test checks just the bookkeeping of the controller
+  mythos::ExecutionContext ec(capAlloc());
+  auto res1 = ec.create(kmem).as(myAS).cs(myCS)
     .prepareStack(thread3stack_top).startFun(&thread_main, nullptr)
-    .suspended(false).fs(tls)
+    .suspended(true)
     .invokeVia(pl).wait();
   TEST(res1);
   TEST(ic.registerForInterrupt(pl, ec.cap(), 0x32).wait());
+  TEST(!ic.registerForInterrupt(pl, ec.cap(), 0x32).wait()); // only one destination
+  auto pending = ic.acknowledge(pl, 0x32).wait();
+  TEST(pending);
+  MLOG_INFO(mlog::app, "interrupts since registration", DVAR(pending->count));
+  TEST(ic.maskIRQ(pl, 0x32).wait());
+  TEST(ic.unmaskIRQ(pl, 0x32).wait());
+  TEST(!ic.acknowledge(pl, 256).wait()); // not a valid vector
   TEST(ic.unregisterInterrupt(pl, 0x32).wait());
   TEST(capAlloc.free(ec, pl));
   MLOG_INFO(mlog::app, "test_InterruptControl end");
@@ -448,6 +733,70 @@ void test_Rapl(){
   MLOG_INFO(mlog::app, "Test RAPL finished");
 }
 
+void test_PerfCounters(){
+  MLOG_INFO(mlog::app, "Test performance counters");
+  mythos::PortalLock pl(portal);
+  mythos::ExecutionContext ec(mythos::init::EC);
+
+  // count instructions retired and branches in general purpose counters
+  uint64_t eventSelect[] = {0xC0, 0xC4, 0, 0};
+  auto res = ec.configureCounters(pl, eventSelect, true, false).wait();
+  if (res.state() == mythos::Error::NOT_IMPLEMENTED) {
+    MLOG_INFO(mlog::app, "SKIP: no performance counters available");
+    return;
+  }
+  TEST(res);
+
+  unsigned numPrimes = 0;
+  for (uint64_t i = 0; i < 20000; i++) {
+    if (primeTest(i)) numPrimes++;
+  }
+
+  auto counters = ec.readCounters(pl).wait();
+  TEST(counters);
+  MLOG_INFO(mlog::app, "counted", DVAR(numPrimes), DVAR(counters->pmc[0]), DVAR(counters->pmc[1]),
+            DVAR(counters->fixed[0]), DVAR(counters->fixed[1]), DVAR(counters->fixed[2]));
+  TEST(counters->pmc[0] > 0);
+
+  uint64_t noEvents[] = {0, 0, 0, 0};
+  TEST(ec.configureCounters(pl, noEvents, false, false).wait());
+  MLOG_INFO(mlog::app, "Test performance counters finished");
+}
+
+void test_PmuSamples(){
+  MLOG_INFO(mlog::app, "Test PMU sample buffers");
+  mythos::PortalLock pl(portal);
+  mythos::Frame f(mythos::init::PMU_SAMPLES);
+  auto info = f.info(pl).wait();
+  if (!info) {
+    MLOG_INFO(mlog::app, "SKIP: no PMU profiler present");
+    return;
+  }
+  uintptr_t vaddr = 512*1024*1024;
+  TEST(myAS.mmap(pl, f, vaddr, info->size, mythos::protocol::PageMap::MapFlags().writable(true)).wait());
+  auto buf = reinterpret_cast<mythos::PmuSampleBuffer*>(vaddr);
+  TEST_EQ(buf->numThreads, info_ptr->getNumThreads());
+
+  unsigned numPrimes = 0;
+  for (uint64_t i = 0; i < 50000; i++) {
+    if (primeTest(i)) numPrimes++;
+  }
+
+  // drain all rings, like a profiling tool would do periodically
+  size_t user = 0, kernel = 0, dropped = 0;
+  for (size_t t = 0; t < buf->numThreads; t++) {
+    auto ring = buf->ring(t);
+    for (; !ring->empty(); ring->pop()) {
+      if (ring->front().flags & mythos::PmuSample::USER) user++;
+      else kernel++;
+    }
+    dropped += ring->dropped.load();
+  }
+  MLOG_INFO(mlog::app, "samples", DVAR(numPrimes), DVAR(buf->period), DVAR(user), DVAR(kernel), DVAR(dropped));
+  TEST(myAS.munmap(pl, vaddr, info->size).wait());
+  MLOG_INFO(mlog::app, "Test PMU sample buffers finished");
+}
+
 void test_CgaScreen(){
   MLOG_INFO(mlog::app, "Test CGA screen");
 
@@ -500,6 +849,33 @@ void test_CgaScreen(){
   MLOG_INFO(mlog::app, "Test CGA finished");
 }
 
+void test_mmapMany(){
+  MLOG_INFO(mlog::app, "Test batched mmap");
+  typedef mythos::protocol::PageMap::MapFlags MapFlags;
+  mythos::PortalLock pl(portal);
+  uintptr_t vaddr = 3ul << 39; // unused PML4 entry, the batch has to create three page maps
+
+  mythos::Frame f(capAlloc());
+  TEST(f.create(pl, kmem, 4*4096, 4096).wait());
+
+  mythos::protocol::PageMap::MmapMany batch(kmem.cap(), MapFlags().writable(true).configurable(true));
+  std::array<mythos::CapPtr, 3> tables = {{capAlloc(), capAlloc(), capAlloc()}};
+  for (auto t : tables) TEST(batch.addTable(t));
+  // every second page stays unmapped
+  for (size_t i = 0; i < 4; i++) TEST(batch.add(f.cap(), vaddr+i*2*4096, 4096, MapFlags().writable(true), i*4096));
+  auto res = myAS.mmapMany(pl, batch).wait();
+  TEST(res);
+  TEST_EQ(res->mapped, 4u);
+  TEST_EQ(res->tables, 3u);
+
+  for (size_t i = 0; i < 4; i++) *reinterpret_cast<volatile size_t*>(vaddr+i*2*4096) = i;
+  for (size_t i = 0; i < 4; i++) TEST_EQ(*reinterpret_cast<volatile size_t*>(vaddr+i*2*4096), i);
+
+  TEST(capAlloc.free(f, pl));
+  for (auto t : tables) TEST(capAlloc.free(t, pl));
+  MLOG_INFO(mlog::app, "End Test batched mmap");
+}
+
 void test_processor_allocator(){
   MLOG_INFO(mlog::app, "Test processor allocator");
   mythos::PortalLock pl(portal);
@@ -521,6 +897,70 @@ void test_process(){
   MLOG_INFO(mlog::app, "Test process finished");
 }
 
+void test_processImage(){
+  MLOG_INFO(mlog::app, "Test process image");
+  typedef mythos::protocol::PageMap::MapFlags MapFlags;
+  mythos::PortalLock pl(portal);
+  uintptr_t vaddr = 6*mythos::align512G;
+
+  // the ELF file has to be in a frame, its read-only segments are mapped from there
+  size_t length = size_t(&process_test_image_end - &process_test_image_start);
+  size_t size = mythos::round_up(length, mythos::align4K);
+  mythos::Frame f(capAlloc());
+  TEST(f.create(pl, kmem, size, mythos::align4K).wait());
+  mythos::protocol::PageMap::MmapMany batch(kmem.cap(), MapFlags().writable(true).configurable(true));
+  std::array<mythos::CapPtr, 3> tables = {{capAlloc(), capAlloc(), capAlloc()}};
+  for (auto t : tables) TEST(batch.addTable(t));
+  TEST(batch.add(f.cap(), vaddr, size, MapFlags().writable(true)));
+  TEST(myAS.mmapMany(pl, batch).wait());
+  mythos::memcpy(reinterpret_cast<void*>(vaddr), &process_test_image_start, length);
+
+  Process p(reinterpret_cast<char*>(vaddr), f);
+  mythos::PageMap pm4(capAlloc());
+  auto res = p.createAddressSpace(pl, pm4);
+  TEST(res);
+  p.freeAddressSpace(pl, pm4);
+
+  // the same with the read-only page maps shared through a template
+  ProcessTemplate tmpl(reinterpret_cast<char*>(vaddr), f);
+  TEST(tmpl.prepare(pl));
+  Process p2(tmpl);
+  mythos::PageMap pm4b(capAlloc());
+  auto res2 = p2.createAddressSpace(pl, pm4b);
+  TEST(res2);
+  p2.freeAddressSpace(pl, pm4b);
+  tmpl.freeTables(pl);
+
+  TEST(capAlloc.free(f, pl));
+  for (auto t : tables) TEST(capAlloc.free(t, pl));
+  MLOG_INFO(mlog::app, "Test process image finished");
+}
+
+void testCapMapDerive(){
+  MLOG_INFO(mlog::app, "Test concurrent CapMap derive and reference");
+  mythos::PortalLock pl(portal);
+  // a second portal owned by this thread, thus both requests are in flight together
+  auto p2 = mythos::portalPool.assign(pl, mythos::init::EC);
+  TEST(p2 != nullptr);
+  mythos::Frame f(capAlloc());
+  TEST(f.create(pl, kmem, 4096, 4096).wait());
+  auto derived = capAlloc();
+  auto referenced = capAlloc();
+  auto r1 = myCS.derive(mythos::PortalLock(*p2), f.cap(), mythos::max_cap_depth,
+                        mythos::null_cap, derived, mythos::max_cap_depth, 0);
+  auto r2 = myCS.reference(pl, f.cap(), mythos::max_cap_depth,
+                           mythos::null_cap, referenced, mythos::max_cap_depth, 0);
+  TEST(r1.wait());
+  TEST(r2.wait());
+  r1.release();
+  r2.release();
+  TEST(capAlloc.free(referenced, pl));
+  TEST(capAlloc.free(derived, pl));
+  TEST(capAlloc.free(f, pl));
+  mythos::portalPool.release(pl, *p2);
+  MLOG_INFO(mlog::app, "Test concurrent CapMap derive and reference finished");
+}
+
 void testCapMapDeletion(){
   MLOG_INFO(mlog::app, "Test CapMap deletion");
 
@@ -543,18 +983,34 @@ int main()
   test_float();
   test_Example();
   test_Portal();
+  test_mmapMany();
   test_heap(); // heap must be initialized for tls test
+  {
+    mythos::PortalLock pl(portal);
+    TEST(mythos::portalPool.init(pl, 2*mythos::align512G)); // own PML4 entry, clear of the tests' mappings
+  }
+  test_EventLoop();
   test_tls();
   test_exceptions();
-  //test_InterruptControl();
+  test_InterruptControl();
   //test_HostChannel(portal, 24*1024*1024, 2*1024*1024);
   test_ExecutionContext();
+  test_pager();
+  test_copyOnWrite();
   test_pthreads();
+  test_affinity();
+  test_log_ring();
+  test_pthread_sync();
   test_Rapl();
+  test_PerfCounters();
+  test_PmuSamples();
   test_processor_allocator();
   //test_process();
+  test_processImage();
   //test_CgaScreen();
   testCapMapDeletion();
+  testCapMapDerive();
+  test_omp(); // last, the hot team keeps its workers
 
   char const end[] = "bye, cruel world!";
   mythos::syscall_debug(end, sizeof(end)-1);
@@ -0,0 +1,79 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include <atomic>
+#include "util/assert.hh"
+#include "async/DeletionMonitor.hh"
+#include "async/Place.hh"
+
+namespace mythos {
+namespace async {
+
+/** Common part of the nested delegating monitors. Each request
+ * remembers its origin place, and the response is processed there.
+ * The exclusive access moves along with the response. Thus, the
+ * response and all subsequently queued requests do not accumulate on
+ * the hardware thread that happened to process the request.
+ */
+class NestedMonitorBase
+  : public DeletionMonitor
+{
+public:
+  NestedMonitorBase() : home(nullptr), requester(nullptr) {}
+
+  /** for compatibility with @c NestedMonitorHome */
+  void setHome(Place*) {}
+
+  /** Processes the response on the place that issued the current
+   * request and moves the exclusive access there. */
+  template<class FUNCTOR>
+  void response(Tasklet* msg, FUNCTOR fun) {
+    Place* dest = requester.load(std::memory_order_relaxed);
+    ASSERT(dest != nullptr);
+    auto& stats = getLocalPlace().getStats();
+    stats.responses++;
+    if (!dest->isLocal()) stats.remoteResponses++;
+    home.store(dest, std::memory_order_relaxed);
+    dest->run(msg->set(fun), Place::MAYINLINE);
+  }
+
+  void responseDone() {}
+
+protected:
+  /** remembers the requester of the task before running it */
+  void runRequest(Place* place, TaskletBase* tsk, Place::Mode mode=Place::ASYNC) {
+    requester.store(static_cast<Tasklet*>(tsk)->getOrigin(), std::memory_order_relaxed);
+    place->runLocal(tsk, mode);
+  }
+
+protected:
+  std::atomic<Place*> home; // the place that owns the exclusive access
+  std::atomic<Place*> requester; // the place that issued the current request
+};
+
+} // namespace async
+} // namespace mythos
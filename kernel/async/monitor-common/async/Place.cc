@@ -31,6 +31,7 @@ namespace async {
 
   CoreLocal<Place*> localPlace_ KERNEL_CLM_HOT;
   Place places[MYTHOS_MAX_THREADS];
+  std::atomic<uint64_t> Place::epoch = {1};
 
   void Place::init(cpu::ThreadID threadID, cpu::ApicID apicID)
   {
@@ -41,34 +42,54 @@ namespace async {
     this->nestingMonitor = true;
     this->queue.tryAcquire();
     this->queueSync.tryAcquire();
+    this->queueBulk.tryAcquire();
   }
 
-    void Place::processSyncTasks()
+    size_t Place::processQueue(Queue& q, size_t max)
     {
-        while (true) {
-            auto msg = queueSync.pull();
-            if (msg != nullptr) msg->run();
-            else break;
+        size_t count = 0;
+        while (count < max) {
+            auto msg = q.pull();
+            if (msg == nullptr) break;
+            stats.tasks++;
+            count++;
+            msg->run();
         }
+        return count;
+    }
+
+    void Place::processSyncTasks()
+    {
+        processQueue(queueSync, size_t(-1));
     }
     
     void Place::processTasks()
     {
         // process tasks until queues are empty and released
         while (true) {
-            processSyncTasks(); // process all high priority tasks first 
-            // now one normal task
-            auto msg = queue.pull();
-            if (msg != nullptr) msg->run();
-            // Have to release the normal queue before the sync queue,
-            // because pushing to the sync queue acquires the normal queue as second step.
-            // Otherwise, messages that arrive at the sync queue after we released
+            auto count = processQueue(queueSync, BATCH_SYNC);
+            count += processQueue(queue, BATCH_NORMAL);
+            count += processQueue(queueBulk, BATCH_BULK);
+            // Release only if all queues were found empty without running
+            // a task in between, because tasks may push into the private queues.
+            // Have to release the normal queue before the other queues,
+            // because pushing to them acquires the normal queue as second step.
+            // Otherwise, messages that arrive at the other queues after we released
             // it can be overseen.
-            else if (queue.tryRelease() && queueSync.tryRelease()) break;
+            if (count == 0 && queue.tryRelease() && queueSync.tryRelease()
+                && queueBulk.tryRelease()) break;
         }
+        // announce the quiescent state, no references are held beyond this point
+        quiescentEpoch.store(epoch.load(std::memory_order_relaxed), std::memory_order_release);
         nestingMonitor.store(false); // release?
     }
 
+  void Place::logStats()
+  {
+    MLOG_INFO(mlog::async, "place statistics", DVAR(threadID), DVAR(stats.tasks),
+              DVAR(stats.inlined), DVAR(stats.responses), DVAR(stats.remoteResponses));
+  }
+
   void Place::setCR3(PhysPtr<void> value)
   {
     ASSERT(isLocal());
@@ -61,6 +61,7 @@ public:
       pushPrivate(msg);
     } else {
       //MLOG_DETAIL(mlog::async, this, "run tasklet", msg);
+      stats.inlined++;
       msg->run();
     }
   }
@@ -82,11 +83,26 @@ public:
     if (queueSync.push(*msg)) preempt();
   }
 
+  /** Runs a low priority task. Use this for bulk maintenance work
+   * like yielding revocations, which must not delay latency sensitive
+   * tasks such as wakeups. Bulk tasks overtake the normal tasks that
+   * were queued before them, thus they must not be used for anything
+   * that relies on the FIFO order of the normal queue, e.g. the visits
+   * of grace periods and broadcasts or the deletion of objects.
+   */
+  void runBulk(TaskletBase* msg) {
+    ASSERT(msg);
+    MLOG_DETAIL(mlog::async, this, "push bulk", msg);
+    if (isLocal()) queueBulk.pushPrivate(*msg);
+    else if (queueBulk.push(*msg)) preempt();
+  }
+
   /** prepare the kernel's task processing. returns true if nested entry. */
   bool enterKernel() {
     // ensure that incoming messages do not send IPI if we entered through local system call
     queue.tryAcquire();
     queueSync.tryAcquire();
+    queueBulk.tryAcquire();
     return nestingMonitor.exchange(true); // relaxed?
   }
 
@@ -99,9 +115,13 @@ public:
       return false;
   }
   
-  /** Processes tasks until the queue is empty and the atomic
+  /** Processes tasks until the queues are empty and the atomic
    * unlocking was successfull. Hence, the next sender will detect
    * that he has to wakeup this place.
+   *
+   * The queues are processed in rounds with a bounded number of
+   * tasks per priority class. Thus, high priority tasks overtake
+   * bulk work without starving it.
    */
   void processTasks();
   
@@ -113,9 +133,43 @@ public:
   /** true if the hardware thread is currently in kernel mode and processing tasks. */
   bool isActive() const { return nestingMonitor.load(std::memory_order_relaxed); }
 
+  /** Global epoch counter for quiescent state based reclamation. A
+   * place that leaves the kernel holds no references to kernel
+   * objects and announces this by recording the current epoch.
+   */
+  static std::atomic<uint64_t> epoch;
+
+  /** the last epoch that was observed when leaving the kernel. */
+  uint64_t getQuiescentEpoch() const { return quiescentEpoch.load(std::memory_order_acquire); }
+
   cpu::ThreadID getThreadID(){ return threadID; }
+  cpu::ApicID getApicID() const { return apicID; }
+
+  /** Tracing counters about the work processed by this place. They
+   * are updated only by the owning hardware thread without
+   * synchronisation, thus remote readers see approximate values.
+   */
+  struct Stats {
+    size_t tasks = 0; //< tasks processed from the queues
+    size_t inlined = 0; //< tasks executed directly by runLocal
+    size_t responses = 0; //< responses sent by the object monitors
+    size_t remoteResponses = 0; //< ... of which were routed to another place
+  };
+
+  Stats& getStats() { return stats; }
+  void logStats();
+
+  /** maximal number of tasks per round and priority class */
+  static constexpr size_t BATCH_SYNC = 32;
+  static constexpr size_t BATCH_NORMAL = 4;
+  static constexpr size_t BATCH_BULK = 1;
 
 protected:
+  typedef TaskletQueueImpl<ChainFIFOBaseAligned> Queue;
+
+  /** runs up to max tasks from the queue and returns their number. */
+  size_t processQueue(Queue& q, size_t max);
+
   void pushPrivate(TaskletBase* msg) {
     ASSERT(isLocal());
     ASSERT(msg);
@@ -129,6 +183,7 @@ protected:
   cpu::ThreadID threadID; //< own thread's linear identifier
   cpu::ApicID apicID; //< for wakeup signals
   std::atomic<bool> nestingMonitor;
+  std::atomic<uint64_t> quiescentEpoch = {0};
 
   /** a copy of the cr3 register. It is used for 1) avoiding a TLB
    * shotdown if setting a value that has not changed, and 2) for
@@ -137,8 +192,11 @@ protected:
    */
   PhysPtr<void> _cr3 = PhysPtr<void>(0ul);
 
-  TaskletQueueImpl<ChainFIFOBaseAligned> queue; //< for pending tasks
-  TaskletQueueImpl<ChainFIFOBaseAligned> queueSync; //< for pending high priority synchronous tasks
+  Stats stats;
+
+  Queue queue; //< for pending tasks
+  Queue queueSync; //< for pending high priority synchronous tasks
+  Queue queueBulk; //< for pending low priority maintenance tasks
 };
 
 
@@ -34,6 +34,8 @@ namespace mythos {
 
 namespace async {
 
+class Place;
+
 class Chainable
 {
 public:
@@ -101,7 +103,9 @@ class alignas(64) Tasklet
 {
 public:
   static constexpr size_t CLSIZE = 64;
-  static constexpr size_t PAYLOAD_SIZE = CLSIZE - sizeof(TaskletBase);
+  /** 40 bytes for the functor, the origin takes 8 bytes of the cacheline.
+   * set() checks the size of each functor at compile time. */
+  static constexpr size_t PAYLOAD_SIZE = CLSIZE - sizeof(TaskletBase) - sizeof(Place*);
 
   Tasklet() {}
   Tasklet(const Tasklet&) = delete;
@@ -119,6 +123,13 @@ public:
     return this;
   }
 
+  /** The place that issued the current request. It is set by the
+   * monitors in order to route the response back to the requester
+   * instead of the place that happened to process the request.
+   */
+  void setOrigin(Place* place) { origin = place; }
+  Place* getOrigin() const { return origin; }
+
 protected:
   // return the function object by copy!
   template<class MSG>
@@ -135,8 +146,9 @@ protected:
 public:
   void print()
   {
-    MLOG_INFO(mlog::async, "tasklet", this, "handler", handler, "hash", hash32(payload, 48));
-    for (auto row = 0; row < 6; ++row) {
+    MLOG_INFO(mlog::async, "tasklet", this, "handler", handler, "origin", origin,
+              "hash", hash32(payload, PAYLOAD_SIZE));
+    for (size_t row = 0; row < PAYLOAD_SIZE/8; ++row) {
       MLOG_DETAIL(mlog::async, DMDUMP(&payload[row*8], 8));
     }
   }
@@ -150,6 +162,7 @@ protected:
   }
 
 private:
+  Place* origin = nullptr;
   char payload[PAYLOAD_SIZE];
 };
 
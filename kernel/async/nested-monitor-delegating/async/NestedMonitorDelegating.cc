@@ -32,6 +32,7 @@ namespace async {
 
   void NestedMonitorDelegating::request(Tasklet* msg) {
     ASSERT(msg);
+    msg->setOrigin(&getLocalPlace());
     if (waitq.push(*msg)) { // first push, acquired exclusive access
       this->acquireRef(); // mark object as used
       Place* myPlace = &getLocalPlace();
@@ -39,7 +40,7 @@ namespace async {
       home.store(myPlace, std::memory_order_relaxed);
       auto tsk = waitq.pull(); // has to be successfull because of our enqueue
       ASSERT(tsk != nullptr);
-      myPlace->runLocal(tsk, Place::MAYINLINE);
+      runRequest(myPlace, tsk, Place::MAYINLINE);
     } // else nothing to do
   }
 
@@ -49,7 +50,7 @@ namespace async {
     auto tsk = waitq.pull(); // try to run the next waiting request
     MLOG_DETAIL(mlog::async, "NMD",this, "requestDone", DVAR(myPlace), DVAR(tsk));
     if (tsk != nullptr) {
-      myPlace->runLocal(tsk);
+      runRequest(myPlace, tsk);
     } else { // try to release
       if (waitq.tryRelease()) { // successfully released
         home.compare_exchange_strong(myPlace, nullptr, std::memory_order_relaxed, std::memory_order_relaxed); // CAREFUL: next pushing thread may already updated home
@@ -57,7 +58,7 @@ namespace async {
       } else { // else retry by processing next task
         tsk = waitq.pull(); // has to be successfull because of failed release
         ASSERT(tsk != nullptr);
-        myPlace->runLocal(tsk);
+        runRequest(myPlace, tsk);
       }
     }
   }
@@ -27,41 +27,28 @@
 
 #include "util/assert.hh"
 #include "async/TaskletQueue.hh"
-#include "async/DeletionMonitor.hh"
-#include "async/Place.hh"
+#include "async/NestedMonitorBase.hh"
 
 namespace mythos {
 namespace async {
 
 class NestedMonitorDelegating
-  : public DeletionMonitor
+  : public NestedMonitorBase
 {
 public:
-  NestedMonitorDelegating() : home(nullptr) {}
+  NestedMonitorDelegating() {}
 
   /** for compatibility with @c NestedMonitorHome */
-  NestedMonitorDelegating(Place*) : home(nullptr) {}
-
-  /** for compatibility with @c NestedMonitorHome */
-  void setHome(Place*) {}
+  NestedMonitorDelegating(Place*) {}
 
   template<class FUNCTOR>
   void request(Tasklet* msg, FUNCTOR fun) { request(msg->set(fun)); }
   void request(Tasklet* msg);
   void requestDone();
 
-  template<class FUNCTOR>
-  void response(Tasklet* msg, FUNCTOR fun) {
-    Place* myPlace = home.load(std::memory_order_relaxed);
-    ASSERT(myPlace != nullptr);
-    myPlace->run(msg->set(fun), Place::MAYINLINE);
-  }
-
-  void responseDone() {}
   void responseAndRequestDone() { requestDone(); }
 
 protected:
-  std::atomic<Place*> home; // used to forward responses to the right place
   TaskletQueue waitq;
 };
 
@@ -0,0 +1,74 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include "async/NestedMonitorFastpath.hh"
+#include "async/mlog.hh"
+
+namespace mythos {
+namespace async {
+
+  void NestedMonitorFastpath::request(Tasklet* msg) {
+    ASSERT(msg);
+    msg->setOrigin(&getLocalPlace());
+    if (waitq.tryAcquire()) { // uncontended: a single CAS, no enqueue
+      MLOG_DETAIL(mlog::async, "NMF",this, "req fast path", DVAR(msg));
+      acquired(msg);
+    } else if (waitq.push(*msg)) { // owner released in the meantime
+      auto tsk = waitq.pull(); // has to be successfull because of our enqueue
+      ASSERT(tsk != nullptr);
+      MLOG_DETAIL(mlog::async, "NMF",this, "req acquired waitq", DVAR(tsk));
+      acquired(tsk);
+    } // else the current owner will process the request
+  }
+
+  void NestedMonitorFastpath::acquired(TaskletBase* msg) {
+    this->acquireRef(); // mark object as used
+    Place* myPlace = &getLocalPlace();
+    home.store(myPlace, std::memory_order_relaxed);
+    runRequest(myPlace, msg, Place::MAYINLINE);
+  }
+
+  void NestedMonitorFastpath::requestDone() {
+    Place* myPlace = home.load(std::memory_order_relaxed);
+    ASSERT(myPlace == &getLocalPlace());
+    auto tsk = waitq.pull(); // try to run the next waiting request
+    MLOG_DETAIL(mlog::async, "NMF",this, "requestDone", DVAR(myPlace), DVAR(tsk));
+    if (tsk != nullptr) {
+      runRequest(myPlace, tsk);
+    } else { // try to release
+      if (waitq.tryRelease()) { // successfully released
+        home.compare_exchange_strong(myPlace, nullptr, std::memory_order_relaxed, std::memory_order_relaxed); // CAREFUL: next acquiring thread may already updated home
+        this->releaseRef(); // mark object as unused
+      } else { // else retry by processing next task
+        tsk = waitq.pull(); // has to be successfull because of failed release
+        ASSERT(tsk != nullptr);
+        runRequest(myPlace, tsk);
+      }
+    }
+  }
+
+} // namespace async
+} // namespace mythos
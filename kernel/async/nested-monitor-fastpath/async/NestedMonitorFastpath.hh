@@ -0,0 +1,65 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include "util/assert.hh"
+#include "async/TaskletQueue.hh"
+#include "async/NestedMonitorBase.hh"
+
+namespace mythos {
+namespace async {
+
+/** Variant of @c NestedMonitorDelegating with a short path for the
+ * uncontended case. A request on a free monitor acquires the wait
+ * queue with a single compare-and-swap and is executed inline
+ * without passing through the queue. Only if the monitor is already
+ * owned, the request is pushed to the wait queue and processed by
+ * the current owner.
+ */
+class NestedMonitorFastpath
+  : public NestedMonitorBase
+{
+public:
+  NestedMonitorFastpath() {}
+
+  /** for compatibility with @c NestedMonitorHome */
+  NestedMonitorFastpath(Place*) {}
+
+  template<class FUNCTOR>
+  void request(Tasklet* msg, FUNCTOR fun) { request(msg->set(fun)); }
+  void request(Tasklet* msg);
+  void requestDone();
+
+  void responseAndRequestDone() { requestDone(); }
+
+protected:
+  void acquired(TaskletBase* msg);
+
+  TaskletQueue waitq;
+};
+
+} // namespace async
+} // namespace mythos
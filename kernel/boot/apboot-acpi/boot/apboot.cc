@@ -32,6 +32,7 @@
 #include "boot/memory-layout.h"
 #include "util/ACPIApicTopology.hh"
 #include "boot/DeployHWThread.hh"
+#include "boot/kernel.hh"
 
 namespace mythos {
 namespace boot {
@@ -63,11 +64,13 @@ NORETURN void apboot() {
     ap_apic2config[topo.threadID(id)] = &ap_config[id];
   }
 
-  //for (int i=0; i<topo.numIOApic(); i++)
-    //initIOApicEvent.trigger_before(i, size_t(topo.ioApicBase(i)));
-
-  // only one ioapic supported yet
-  initIOApicEvent.emit(0, reinterpret_cast<size_t>(topo.ioApicBase()));
+  for (size_t i=0; i<topo.numIOApics(); i++) {
+    event::initIOApic.emit(int(i), topo.ioApicBase(i), topo.ioApicGSIBase(i));
+  }
+  for (size_t i=0; i<topo.numSourceOverrides(); i++) {
+    auto& o = topo.sourceOverride(i);
+    event::irqSourceOverride.emit(o.source, o.gsi, o.flags);
+  }
 
 
   DeployHWThread::prepareBSP();
@@ -38,6 +38,8 @@
 #include "cpu/idle.hh"
 #include "async/Place.hh"
 #include "objects/DeleteBroadcast.hh"
+#include "objects/PML4InvalidationBroadcastAmd64.hh"
+#include "objects/TLBShootdownBroadcastAmd64.hh"
 #include "objects/SchedulingContext.hh"
 #include "objects/InterruptControl.hh"
 #include "boot/memory-layout.h"
@@ -78,6 +80,8 @@ struct DeployHWThread
   {
     idt.init();
     DeleteBroadcast::init(); // depends on hwthread enumeration
+    PML4InvalidationBroadcast::init(); // depends on hwthread enumeration
+    TLBShootdownBroadcast::init(); // depends on hwthread enumeration
   }
 
   void prepare(cpu::ThreadID threadID, cpu::ApicID apicID)
@@ -99,6 +103,7 @@ struct DeployHWThread
     async::getPlace(threadID)->init(threadID, apicID);
     localScheduler.setAt(threadID, &getScheduler(threadID));
     localInterruptController.setAt(threadID, &getInterruptController(threadID));
+    getInterruptController(threadID).init(async::getPlace(threadID));
     getScheduler(threadID).init(async::getPlace(threadID));
     cpu::initSyscallStack(threadID, stacks[apicID]);
     MLOG_DETAIL(mlog::boot, "  hw thread", DVAR(threadID), DVAR(apicID),
@@ -65,7 +65,9 @@ NORETURN void apboot() {
     ap_apic2config[topo.threadID(id)] = &ap_config[id];
   }
 
-  event::initIOApic.emit(0, topo.ioapic_address());
+  for (size_t i=0; i<topo.numIOApics(); i++) {
+    event::initIOApic.emit(int(i), topo.ioapic_address(i), event::GSI_AFTER_PREVIOUS);
+  }
 
   DeployHWThread::prepareBSP();
 
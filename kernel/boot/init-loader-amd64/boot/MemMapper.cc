@@ -93,13 +93,25 @@ optional<void> MemMapper::mmapDevice(
     auto memEntry = caps->get(init::DEVICE_MEM);
     TypedCap<DeviceMemory> mem(memEntry);
     if (!mem) RETHROW(mem);
-    auto dstPtr = caps->alloc();
-    if (!dstPtr) RETHROW(dstPtr);
-    auto dstEntry = caps->get(*dstPtr);
-    if (!dstEntry) RETHROW(dstEntry);
-    auto res = mem->deriveFrame(**memEntry, memEntry->cap(), **dstEntry, physaddr, length, false);
-    if (!res) RETHROW(res);
-    RETURN(mmap(vaddr, length, writable, executable, *dstPtr, 0)); // offset 0 of the derived frame
+    if (!is_aligned(length, align4K)) THROW(Error::UNALIGNED);
+
+    // frames have power of two sizes, hence split the range into the largest fitting ones
+    while (length > 0) {
+        size_t chunk = align4K;
+        while (chunk*2 <= length) chunk *= 2;
+        auto dstPtr = caps->alloc();
+        if (!dstPtr) RETHROW(dstPtr);
+        auto dstEntry = caps->get(*dstPtr);
+        if (!dstEntry) RETHROW(dstEntry);
+        auto res = mem->deriveFrame(**memEntry, memEntry->cap(), **dstEntry, physaddr, chunk, false);
+        if (!res) RETHROW(res);
+        res = mmap(vaddr, chunk, writable, executable, *dstPtr, 0); // offset 0 of the derived frame
+        if (!res) RETHROW(res);
+        vaddr += chunk;
+        physaddr += chunk;
+        length -= chunk;
+    }
+    RETURN(Error::SUCCESS);
 }
 
 optional<void> MemMapper::mmap(
@@ -61,7 +61,10 @@ public:
      *  address in the capspace. */
     optional<void> installPML4(CapPtr dstCap);
 
-    /** map a frame and create missing tables on demand. */
+    /** map a range of physical memory and create missing tables on demand.
+     *  The range is covered by derived device frames, which the kernel does not
+     *  access itself. Hence, this works for memory that is already
+     *  initialised, such as the read-only parts of the embedded init image. */
     optional<void> mmapDevice(
         uintptr_t vaddr, size_t length,
         bool writable, bool executable,
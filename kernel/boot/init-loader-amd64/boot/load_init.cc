@@ -46,6 +46,7 @@
 #include "boot/memory-root.hh"
 #include "boot/DeployHWThread.hh"
 #include "mythos/InfoFrame.hh"
+#include <atomic>
 
 
 namespace mythos {
@@ -229,17 +230,24 @@ optional<void> InitLoader::createPortal(CapPtr infoFrame, CapPtr dstPortal)
     RETURN(Error::SUCCESS);
 }
 
+bool InitLoader::isSharedSegment(const elf64::PHeader* ph) const
+{
+    // read-only, no bss, and the file offset fits to the page offset in the logical address space
+    return !(ph->flags & elf64::PF_W) && ph->filesize == ph->memsize &&
+        is_aligned(reinterpret_cast<uintptr_t>(_img.getData(*ph)) - ph->vaddr, align4K);
+}
+
 optional<uintptr_t> InitLoader::loadImage()
 {
     uintptr_t ipc_addr = round_up(1u, align2M);
-    // 1) figure out how much bytes we need
+    // 1) figure out how much bytes we need for the segments that have to be copied
     size_t size = 0;
     for (size_t i=0; i <_img.phnum(); ++i) {
         auto ph = _img.phdr(i);
         if (ph->type == elf64::PT_LOAD) {
             auto begin = round_down(ph->vaddr, align2M);
             auto end = round_up(ph->vaddr + ph->memsize, align2M);
-            size += end-begin;
+            if (!isSharedSegment(ph)) size += end-begin;
             if (end >= ipc_addr) {
               ipc_addr = round_up(end + 1u, align2M);
             }
@@ -247,19 +255,29 @@ optional<uintptr_t> InitLoader::loadImage()
     }
 
     // 2) allocate a frame
-    auto frameCap = memMapper.createFrame(size, 2*1024*1024);
-    if (!frameCap) RETHROW(frameCap);
-    MLOG_INFO(mlog::boot, "... allocated frame for application image",
-        DVAR(*frameCap), DVAR(size));
+    CapPtr frameCap = null_cap;
+    if (size > 0) {
+        auto res = memMapper.createFrame(size, 2*1024*1024);
+        if (!res) RETHROW(res);
+        frameCap = *res;
+        MLOG_INFO(mlog::boot, "... allocated frame for application image",
+            DVAR(frameCap), DVAR(size));
+    }
 
-    // 3) process each program header: map to page, copy contents
+    // 3) process each program header: map read-only segments directly
+    // from the image, map to page and copy contents for the others
     size_t offset = 0;
     for (size_t i=0; i <_img.phnum(); ++i) {
         auto ph = _img.phdr(i);
         if (ph->type == elf64::PT_LOAD) {
+            if (isSharedSegment(ph)) {
+                auto res = mapProgramHeader(ph);
+                if (!res) RETHROW(res);
+                continue;
+            }
             auto begin = round_down(ph->vaddr, align2M);
             auto end = round_up(ph->vaddr + ph->memsize, align2M);
-            auto res = loadProgramHeader(ph, *frameCap, offset);
+            auto res = loadProgramHeader(ph, frameCap, offset);
             if (!res) RETHROW(res);
             offset += end-begin;
         }
@@ -267,6 +285,20 @@ optional<uintptr_t> InitLoader::loadImage()
     return ipc_addr;
 }
 
+optional<void> InitLoader::mapProgramHeader(const elf64::PHeader* ph)
+{
+    MLOG_INFO(mlog::boot, "... map PH", DVAR(ph->type), DVAR(ph->flags), DVARhex(ph->offset),
+        DVARhex(ph->vaddr), DVARhex(ph->filesize), DVARhex(ph->memsize));
+
+    auto vbegin = round_down(ph->vaddr, align4K);
+    auto vend = round_up(ph->vaddr+ph->filesize, align4K);
+    if (vend-vbegin == 0) RETURN(Error::SUCCESS); // nothing to do
+
+    // the image is part of the kernel image and stays there forever
+    auto pbegin = round_down(PhysPtr<void>::fromImage(_img.getData(*ph)).physint(), align4K);
+    RETURN(memMapper.mmapDevice(vbegin, vend-vbegin, false, ph->flags&elf64::PF_X, pbegin));
+}
+
 optional<void> InitLoader::loadProgramHeader(
     const elf64::PHeader* ph, CapPtr frameCap, size_t offset)
 {
@@ -291,14 +323,15 @@ optional<void> InitLoader::loadProgramHeader(
     if (!frame) RETHROW(frame);
     auto frameInfo = frame.getFrameInfo();
 
-    // zero the pages, then copy the data
+    // copy the data and zero just the remaining parts of the pages
     auto pstart = frameInfo.start.plusbytes(offset);
+    auto head = ph->vaddr - vbegin;
+    auto tail = head + ph->filesize;
     //MLOG_INFO(mlog::boot, "    zeroing", DVARhex(pstart), DVARhex(vend-vbegin));
-    memset(pstart.log(), 0, vend-vbegin);
-    pstart.incbytes(ph->vaddr - vbegin);
-    //MLOG_INFO(mlog::boot, "    zeroing2", DVARhex(pstart), DVARhex(vend-vbegin));
-    memcpy(pstart.log(), _img.getData(*ph), ph->filesize);
-    //MLOG_INFO(mlog::boot, "    zeroing3", DVARhex(pstart), DVARhex(vend-vbegin));
+    memset(pstart.log(), 0, head);
+    memcpy(pstart.plusbytes(head).log(), _img.getData(*ph), ph->filesize);
+    // a large bss would just flush the caches, hence bypass them
+    memzero_nt(pstart.plusbytes(tail).log(), vend-vbegin-tail);
     RETURN(Error::SUCCESS);
 }
 
@@ -320,6 +353,32 @@ optional<void> InitLoader::createEC(uintptr_t ipc_vaddr)
   RETURN(Error::SUCCESS);
 }
 
+/** idle hardware threads write the init application's log ring to the
+ * kernel's log sink, so that the application rarely has to ask for it. */
+class InitLogDrain
+  : public EventHook<InfoFrame*>
+  , public EventHook<cpu::ThreadID>
+{
+public:
+  InitLogDrain() : ring(nullptr) {
+    event::initInfoFrame.add(this);
+    event::idleThread.add(this);
+  }
+  virtual ~InitLogDrain() {}
+
+  void processEvent(InfoFrame* info) override { ring.store(info->getLogRing()); }
+
+  void processEvent(cpu::ThreadID) override {
+    auto r = ring.load();
+    if (r && r->fill() != 0)
+      r->drain([](char const* str, size_t len) { mlog::sink->write(str, len); });
+  }
+
+protected:
+  std::atomic<LogRing*> ring;
+};
+
+InitLogDrain initLogDrain;
 
 } // namespace boot
 } // namespace mythos
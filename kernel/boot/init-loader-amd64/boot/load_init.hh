@@ -64,6 +64,10 @@ namespace mythos {
       optional<void> loadProgramHeader(
         const elf64::PHeader* ph, CapPtr frameCap, size_t offset);
 
+      /** read-only segments are mapped from the image instead of being copied. */
+      bool isSharedSegment(const elf64::PHeader* ph) const;
+      optional<void> mapProgramHeader(const elf64::PHeader* ph);
+
       template<class Object, class Factory, class... ARGS>
       optional<Object*> create(optional<CapEntry*> dstEntry, ARGS const&...args);
 
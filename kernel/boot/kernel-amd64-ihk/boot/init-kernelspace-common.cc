@@ -28,6 +28,7 @@
 #include "boot/pagetables.hh"
 #include "boot/memory-layout.h"
 #include "boot/mlog.hh"
+#include "util/assert.hh"
 
 extern char KERN_ROEND;
 extern char KERN_END;
@@ -70,9 +71,11 @@ void mapLapic(uintptr_t phys)
   devices_pml1[1] = CD + PRESENT + WRITE + ACCESSED + DIRTY + GLOBAL + phys;
 }
 
-void mapIOApic(uintptr_t phys) {
-  MLOG_INFO(mlog::boot, "map ioapic", DVARhex(phys));
+uintptr_t mapIOApic(size_t idx, uintptr_t phys) {
+  PANIC_MSG(idx < IOAPIC_MAX, "unexpectedly many ioapics");
+  MLOG_INFO(mlog::boot, "map ioapic", DVAR(idx), DVARhex(phys));
   devices_pml1[2] = CD + PRESENT + WRITE + ACCESSED + DIRTY + GLOBAL + phys;
+  return IOAPIC_ADDR;
 }
 
 void mapTrampoline(uintptr_t phys) {
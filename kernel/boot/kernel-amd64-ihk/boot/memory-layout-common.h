@@ -62,6 +62,7 @@
 #define LAPIC_ADDR          0xffff810100001000
 /** IOAPIC_START fixed mapping of the global ioapics */
 #define IOAPIC_ADDR			0xffff810100002000
+#define IOAPIC_MAX          1
 /** TRAMPOLINE_ADDR fixed mapping of the IHK trampoline */
 #define IHK_TRAMPOLINE_ADDR	0xffff810100003000
 #define LOW_MEM_ADDR      	0xffff810100004000
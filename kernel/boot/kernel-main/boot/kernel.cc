@@ -41,6 +41,7 @@
 #include "cpu/idle.hh"
 #include "cpu/hwthread_pause.hh"
 #include "cpu/fpu.hh"
+#include "cpu/PmcState.hh"
 #include "boot/memory-layout.h"
 #include "boot/DeployKernelSpace.hh"
 #include "boot/DeployHWThread.hh"
@@ -60,7 +61,8 @@
 
 mythos::Event<> mythos::event::bootBSP;
 mythos::Event<mythos::cpu::ThreadID, bool, size_t> mythos::event::bootAP;
-mythos::Event<int, size_t> mythos::event::initIOApic;
+mythos::Event<int, size_t, uint32_t> mythos::event::initIOApic;
+mythos::Event<uint8_t, uint32_t, uint16_t> mythos::event::irqSourceOverride;
 
 ALIGN_4K uint8_t boot_stack[BOOT_STACK_SIZE] SYMBOL("BOOT_STACK");
 extern char CLM_ADDR;
@@ -101,6 +103,7 @@ void entry_bsp()
   mythos::idle::init_global();
   mythos::boot::initKernelMemory(*mythos::boot::kmem_root());
   mythos::cpu::FpuState::initBSP(); // TODO do this as a plugin with high priority
+  mythos::cpu::PmcState::initBSP();
   mythos::event::bootBSP.emit();
   mythos::boot::apboot(); // does not return, jumps to entry_ap()
   PANIC_MSG(false, "should never reach here");
@@ -161,7 +164,9 @@ void mythos::cpu::irq_entry_user(mythos::cpu::ThreadState* ctx)
   mythos::idle::enteredFromInterrupt();
   MLOG_DETAIL(mlog::boot, "user interrupt", DVARhex(ctx->irq), DVARhex(ctx->error),
       DVARhex(ctx->rip), DVARhex(ctx->rsp));
-  if (ctx->irq<32) {
+  if (ctx->irq == 2 && mythos::irq_usernmi) {
+    mythos::irq_usernmi->process(ctx); // e.g. sampling, the execution context just continues
+  } else if (ctx->irq<32) {
     mythos::ec_handle_trap(); // handle traps, exceptions, bugs from user mode
   } else {
     mythos::ec_interrupted(); // inform the current execution context that it was interrupted
@@ -33,10 +33,21 @@ extern Event<> bootBSP;
 extern Event<cpu::ThreadID, bool, size_t> bootAP;
 
 /** event to initialize an ioApic.
- * Arguments are the number of the ioAPIC and its physical address.
+ * Arguments are the number of the ioAPIC, its physical address, and
+ * the global system interrupt of its first redirection entry. The MP
+ * table does not report the latter, GSI_AFTER_PREVIOUS places the
+ * ioAPIC behind the previous one.
  * The memory mapping is up to the plugins.
  */
-extern Event<int, size_t> initIOApic;
+extern Event<int, size_t, uint32_t> initIOApic;
+constexpr uint32_t GSI_AFTER_PREVIOUS = ~uint32_t(0);
+
+/** event for an ACPI interrupt source override, emitted after all
+ * ioApics were initialised. Arguments are the ISA interrupt, the global
+ * system interrupt it is connected to, and the MPS INTI flags with
+ * its polarity and trigger mode.
+ */
+extern Event<uint8_t, uint32_t, uint16_t> irqSourceOverride;
 
     } // namespace event
 } // namespace mythos
@@ -27,6 +27,8 @@
 #include "boot/DeployKernelSpace.hh"
 #include "boot/pagetables.hh"
 #include "boot/memory-layout.h"
+#include "boot/mlog.hh"
+#include "util/assert.hh"
 
 extern char KERN_ROEND;
 extern char KERN_END;
@@ -70,10 +72,12 @@ void mapLapic(uintptr_t phys)
   devices_pml1[1] = CD + PRESENT + WRITE + ACCESSED + DIRTY + GLOBAL + phys;
 }
 
-void mapIOApic(uintptr_t phys) {
+uintptr_t mapIOApic(size_t idx, uintptr_t phys) {
   static_assert(IOAPIC_ADDR == 0xffff800100002000, "failed assumption about kernel layout");
-  MLOG_ERROR(mlog::boot, "map ioapic", DVARhex(phys));
-  devices_pml1[2] = CD + PRESENT + WRITE + ACCESSED + DIRTY + GLOBAL + phys;
+  PANIC_MSG(idx < IOAPIC_MAX, "unexpectedly many ioapics");
+  MLOG_INFO(mlog::boot, "map ioapic", DVAR(idx), DVARhex(phys));
+  devices_pml1[2 + idx] = CD + PRESENT + WRITE + ACCESSED + DIRTY + GLOBAL + phys;
+  return IOAPIC_ADDR + 4096*idx;
 }
 
 uintptr_t initKernelStack(size_t idx, uintptr_t paddr)
@@ -39,7 +39,8 @@ namespace mythos {
     void loadKernelSpace();
 
     void mapLapic(uintptr_t phys);
-    void mapIOApic(uintptr_t phys);
+    /** maps the idx-th IOAPIC and returns its logical address */
+    uintptr_t mapIOApic(size_t idx, uintptr_t phys);
 
     /** maps a kernel stack to the given physical address and returns the logical address */
     uintptr_t initKernelStack(size_t idx, uintptr_t paddr);
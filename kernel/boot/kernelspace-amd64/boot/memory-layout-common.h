@@ -64,8 +64,9 @@
 #define DEVICES_ADDR        0xffff800100000000
 /** LAPIC_START fixed mapping of the hardware thread's local APIC */
 #define LAPIC_ADDR          0xffff800100001000
-/** IOAPIC_START fixed mapping of the global ioapics */
+/** IOAPIC_START fixed mapping of the global ioapics, one page each */
 #define IOAPIC_ADDR			0xffff800100002000
+#define IOAPIC_MAX          8
 #define KERNELSTACKS_ADDR   0xffff800100200000
 
 #define BOOT_STACK_SIZE     2*4096
@@ -30,6 +30,7 @@
 #include "objects/ops.hh"
 #include "objects/KernelMemory.hh"
 #include "objects/DeviceMemory.hh"
+#include "objects/SchedulingContext.hh"
 #include "boot/mlog.hh"
 
 namespace mythos {
@@ -51,5 +52,21 @@ namespace mythos {
       cap::inherit(device_memory_root_entry(), device_memory_root_entry().cap(), 
                    *kmem_root_entry(), Cap(kmem_root()));
     }
+
+    /** idle hardware threads refill the root memory's pools of
+     * pre-zeroed blocks, one block per idle period. */
+    class ZeroPoolRefill
+      : public EventHook<cpu::ThreadID>
+    {
+    public:
+      ZeroPoolRefill() { event::idleThread.add(this); }
+      virtual ~ZeroPoolRefill() {}
+
+      void processEvent(cpu::ThreadID) override {
+        if (kmem_root()->needsRefill()) kmem_root()->refillZeroed(getLocalPlace());
+      }
+    };
+
+    ZeroPoolRefill zeroPoolRefill;
   } // namespace boot
 } // namespace mythos
@@ -25,23 +25,14 @@
  */
 
 #include <cstddef> // for size_t
+#include "util/mstring.hh"
 
 extern "C" void* memcpy(void* dst, void const* src, size_t count) {
-    char* d = reinterpret_cast<char*>(dst);
-    char const* s = reinterpret_cast<char const*>(src);
-    for(size_t index = 0; index < count; index++){
-      d[index] = s[index];
-    }
-    return dst;
+    return mythos::memcpy(dst, src, count);
 }
 
 extern "C" void* memset(void* dst, int value, size_t count) {
-    char* d = reinterpret_cast<char*>(dst);
-    char s = (char)value;
-    for(size_t index = 0; index < count; index++){
-      d[index] = s;
-    }
-    return dst;
+    return mythos::memset(dst, char(value), count);
 }
 
 extern "C" size_t strlen(const char *s) {
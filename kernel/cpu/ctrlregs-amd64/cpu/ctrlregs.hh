@@ -444,6 +444,10 @@ namespace mythos {
       //Indicator that core perfmon interface is in
       //use. (RO)
       IA32_PERF_GLOBAL_INUSE = 0x392,
+
+      //Full width writable alias of IA32_PMC0 (R/W)
+      //If IA32_PERF_CAPABILITIES[13] = 1
+      IA32_A_PMC0 = 0x4C1,
     };
 
   } // namespace x86
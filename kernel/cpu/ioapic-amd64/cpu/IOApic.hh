@@ -27,12 +27,15 @@
 #pragma once
 
 #include "util/bitfield.hh"
+#include "util/TidexMutex.hh"
+#include "cpu/hwthreadid.hh"
 #include "cpu/IOApicDef.hh"
 
 namespace mythos {
 
 class IOApic : public IOApicDef {
 public:
+    enum { MAX_IOAPICS = 8 };
 
     BITFIELD_DEF(uint64_t, RED_TABLE_ENTRY)
     UIntField<value_t,base_t, 0,8> intvec; // interrupt vector from 0x20 to 0xFE
@@ -67,6 +70,10 @@ public:
     void write(size_t reg, uint32_t value) override;
     void maskIRQ(uint64_t irq) override;
     void unmaskIRQ(uint64_t irq) override;
+    void routeIRQ(uint64_t irq, uint32_t apicID) override;
+    /** sets how the global system interrupt gsi is signalled, which
+     * differs from the defaults for overridden ISA interrupts. */
+    void setTriggerMode(uint32_t gsi, bool level, bool lowActive);
     RED_TABLE_ENTRY readTableEntry(size_t table_entry);
     void writeTableEntry(size_t table_entry, RED_TABLE_ENTRY rte);
     
@@ -74,8 +81,13 @@ private:
     void init();
     void setBase(size_t base_address_) override { base_address = (uint32_t volatile*) base_address_; }
     uint32_t volatile *base_address = {nullptr};
+    /** the register window needs two accesses, which must not interleave
+     * between hardware threads */
+    TidexMutex<KernelMutexContext> mutex;
 };
 
-extern IOApic ioapic;
+/** all IOAPICs in the order of discovery */
+extern IOApic ioapics[IOApic::MAX_IOAPICS];
+extern size_t numIOApics;
 
 } // namespace mythos
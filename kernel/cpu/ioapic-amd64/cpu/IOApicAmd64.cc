@@ -25,32 +25,98 @@
  */
 
 #include "cpu/IOApic.hh"
+#include "boot/mlog.hh"
+#include "boot/kernel.hh"
+#include "boot/init-kernelspace-common.hh"
+#include "util/events.hh"
+#include "util/assert.hh"
 
 namespace mythos {
-  IOApic ioapic;
+  IOApic ioapics[IOApic::MAX_IOAPICS];
+  size_t numIOApics = 0;
 
-  void IOApic::init() {
-    IOAPIC_VERSION ver(read(IOApic::IOAPICVER));
-    MLOG_INFO(mlog::boot, "IOAPIC", DVAR(ver.version), DVAR(ver.max_redirection_table));
+  /** maps and initialises the IOAPICs that were found by the boot code.
+   * The global system interrupt base comes from the MADT. IOAPICs from
+   * the MP table follow the previous one.
+   */
+  class InitIOApicHook
+    : public EventHook<int, size_t, uint32_t>
+  {
+  public:
+    InitIOApicHook() { event::initIOApic.add(this); }
+
+    void processEvent(int idx, size_t phys, uint32_t gsiBase) override {
+      if (phys == 0) return;
+      if (numIOApics == IOApic::MAX_IOAPICS) {
+        MLOG_WARN(mlog::boot, "too many IOAPICs, ignoring", DVAR(idx), DVARhex(phys));
+        return;
+      }
+      auto& io = ioapics[numIOApics];
+      if (gsiBase == event::GSI_AFTER_PREVIOUS) {
+        gsiBase = 0;
+        if (numIOApics > 0) {
+          auto& prev = ioapics[numIOApics-1];
+          gsiBase = prev.getGSIBase() + prev.getNumEntries();
+        }
+      }
+      io.setGSIBase(gsiBase);
+      io.init(boot::mapIOApic(numIOApics, phys));
+      numIOApics++;
+    }
+  };
+
+  InitIOApicHook initIOApicHook;
 
-    RED_TABLE_ENTRY rte_irq;
-    rte_irq.trigger_mode = 0;
-    rte_irq.intpol = 0;
+  /** applies the polarity and trigger mode of an interrupt source
+   * override to the redirection entry of its global system interrupt.
+   */
+  class IrqSourceOverrideHook
+    : public EventHook<uint8_t, uint32_t, uint16_t>
+  {
+  public:
+    IrqSourceOverrideHook() { event::irqSourceOverride.add(this); }
+
+    void processEvent(uint8_t source, uint32_t gsi, uint16_t flags) override {
+      // MPS INTI flags, 0 conforms to the ISA bus: edge triggered and high active
+      auto polarity = flags & 0x3;
+      auto trigger = (flags >> 2) & 0x3;
+      for (size_t i = 0; i < numIOApics; i++) {
+        if (!ioapics[i].servesIRQ(IOApic::BASE_IRQ + gsi)) continue;
+        MLOG_INFO(mlog::boot, "IOAPIC source override", DVAR(source), DVAR(gsi), DVARhex(flags));
+        ioapics[i].setTriggerMode(gsi, trigger == 3, polarity == 3);
+        return;
+      }
+      MLOG_WARN(mlog::boot, "no IOAPIC for source override", DVAR(source), DVAR(gsi));
+    }
+  };
 
-    RED_TABLE_ENTRY rte_pci; // interrupts 16..19
-    rte_pci.trigger_mode = 1; // level triggered
-    rte_pci.intpol = 1; // low active
+  IrqSourceOverrideHook irqSourceOverrideHook;
 
-    for (size_t i = 0; i < 16; i++) {
-      rte_irq.dest = 0x21 + i;
-      write(IOApic::IOREDTBL_BASE+2*i, (uint32_t) rte_irq.lower);
-      write(IOApic::IOREDTBL_BASE+2*i+1, (uint32_t) rte_irq.upper);
+  IOApicDef* findIOApic(uint64_t irq) {
+    for (size_t i = 0; i < numIOApics; i++) {
+      if (ioapics[i].servesIRQ(irq)) return &ioapics[i];
     }
+    return nullptr;
+  }
 
-    for (size_t i = 16; i < ver.max_redirection_table + 1; i++) {
-      rte_irq.dest = 0x21 + i;
-      write(IOApic::IOREDTBL_BASE+2*i, (uint32_t) rte_pci.lower);
-      write(IOApic::IOREDTBL_BASE+2*i+1, (uint32_t) rte_pci.upper);
+  void IOApic::init() {
+    IOAPIC_VERSION ver(read(IOApic::IOAPICVER));
+    numEntries = ver.max_redirection_table + 1;
+    MLOG_INFO(mlog::boot, "IOAPIC", DVAR(ver.version), DVAR(gsiBase), DVAR(numEntries));
+
+    // all entries stay masked until someone registers for the interrupt
+    for (size_t i = 0; i < numEntries; i++) {
+      RED_TABLE_ENTRY rte;
+      rte.int_mask = 1;
+      rte.destmode = PHYS_MODE;
+      rte.dest = 0;
+      // entries beyond vector 255 are never unmasked
+      if (BASE_IRQ + gsiBase + i < 256) rte.intvec = BASE_IRQ + gsiBase + i;
+      if (gsiBase + i >= 16) { // PCI interrupts
+        rte.trigger_mode = 1; // level triggered
+        rte.intpol = 1; // low active
+      }
+      writeTableEntry(i, rte);
     }
   }
 
@@ -82,8 +148,9 @@ namespace mythos {
    * In other cases the used mapping has to be remembered or all redirection entries have to be searched through.
    */
   void IOApic::maskIRQ(uint64_t irq) {
-    ASSERT(irq > 31 && irq < 256);
-    auto table_entry = irq - IOApic::BASE_IRQ;
+    ASSERT(servesIRQ(irq));
+    TidexMutex<KernelMutexContext>::Lock guard(mutex);
+    auto table_entry = irq - IOApic::BASE_IRQ - gsiBase;
     IOApic::RED_TABLE_ENTRY rte = readTableEntry(table_entry);
     rte.int_mask = 1;
     writeTableEntry(table_entry, rte);
@@ -91,12 +158,33 @@ namespace mythos {
 
   /// Same as maskIRQ
   void IOApic::unmaskIRQ(uint64_t irq) {
-    ASSERT(irq > 31 && irq < 256);
-    auto table_entry = irq - IOApic::BASE_IRQ;
+    ASSERT(servesIRQ(irq));
+    TidexMutex<KernelMutexContext>::Lock guard(mutex);
+    auto table_entry = irq - IOApic::BASE_IRQ - gsiBase;
     IOApic::RED_TABLE_ENTRY rte = readTableEntry(table_entry);
     rte.int_mask = 0;
     writeTableEntry(table_entry, rte);
   }
 
-} // namespace mythos
+  void IOApic::setTriggerMode(uint32_t gsi, bool level, bool lowActive) {
+    ASSERT(servesIRQ(IOApic::BASE_IRQ + gsi));
+    TidexMutex<KernelMutexContext>::Lock guard(mutex);
+    auto table_entry = gsi - gsiBase;
+    IOApic::RED_TABLE_ENTRY rte = readTableEntry(table_entry);
+    rte.trigger_mode = level;
+    rte.intpol = lowActive;
+    writeTableEntry(table_entry, rte);
+  }
 
+  void IOApic::routeIRQ(uint64_t irq, uint32_t apicID) {
+    ASSERT(servesIRQ(irq));
+    TidexMutex<KernelMutexContext>::Lock guard(mutex);
+    auto table_entry = irq - IOApic::BASE_IRQ - gsiBase;
+    IOApic::RED_TABLE_ENTRY rte = readTableEntry(table_entry);
+    rte.destmode = PHYS_MODE;
+    rte.delmode = 0; // fixed
+    rte.dest = apicID;
+    writeTableEntry(table_entry, rte);
+  }
+
+} // namespace mythos
@@ -69,6 +69,7 @@ public:
     void write(size_t reg, uint32_t value) override;
     void maskIRQ(uint64_t irq) override;
     void unmaskIRQ(uint64_t irq) override;
+    void routeIRQ(uint64_t irq, uint32_t apicID) override;
     RED_TABLE_ENTRY readTableEntry(size_t table_entry);
     void writeTableEntry(size_t table_entry, RED_TABLE_ENTRY rte);
 private:
@@ -30,6 +30,10 @@
 namespace mythos {
   IOApic ioapic;
 
+  IOApicDef* findIOApic(uint64_t irq) {
+    return ioapic.servesIRQ(irq) ? &ioapic : nullptr;
+  }
+
   /*
    * +        * 0    DMA Completion Interrupt for Channel 0 NOT USED
    * +        * 1    DMA Completion Interrupt for Channel 1 NOT USED
@@ -63,6 +67,7 @@ namespace mythos {
     ASSERT(base_address != nullptr);
     IOApic::IOAPIC_VERSION ver(read(IOApic::IOAPICVER));
     MLOG_DETAIL(mlog::boot, "IOAPIC init", DVAR(ver.version), DVAR(ver.max_redirection_table));
+    numEntries = ver.max_redirection_table + 1;
 
     RED_TABLE_ENTRY rte_irq;
     rte_irq.trigger_mode = 0;
@@ -122,4 +127,14 @@ namespace mythos {
     writeTableEntry(table_entry, rte);
   }
 
+  void IOApic::routeIRQ(uint64_t irq, uint32_t apicID) {
+    ASSERT(irq > 31 && irq < 256);
+    ASSERT(base_address != nullptr);
+    auto table_entry = irq - IOApic::BASE_IRQ;
+    IOApic::RED_TABLE_ENTRY rte = readTableEntry(table_entry);
+    rte.destmode = 0; // physical
+    rte.dest = apicID;
+    writeTableEntry(table_entry, rte);
+  }
+
 } // namespace mythos
@@ -26,6 +26,10 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstddef>
+#include "util/bitfield.hh"
+
 namespace mythos {
 
 class IOApicDef {
@@ -73,9 +77,29 @@ public:
     virtual void write(size_t reg, uint32_t value) = 0;
     virtual void maskIRQ(uint64_t irq) = 0;
     virtual void unmaskIRQ(uint64_t irq) = 0;
+    /** deliver the interrupt to the local APIC with the given physical ID. */
+    virtual void routeIRQ(uint64_t irq, uint32_t apicID) = 0;
+
+    /** true if the interrupt vector belongs to one of the redirection
+     * entries, assuming the continuous mapping starting at BASE_IRQ. */
+    bool servesIRQ(uint64_t irq) const {
+      return irq >= BASE_IRQ + gsiBase && irq < BASE_IRQ + gsiBase + numEntries;
+    }
+    void setGSIBase(uint32_t base) { gsiBase = base; }
+    uint32_t getGSIBase() const { return gsiBase; }
+    uint32_t getNumEntries() const { return numEntries; }
+
+protected:
+    uint32_t gsiBase = 0; //< global system interrupt of the first redirection entry
+    uint32_t numEntries = 0; //< number of redirection entries, known after init
 
 private:
     virtual void setBase(size_t base_address_) = 0;
 };
 
+/** the IOAPIC that serves the interrupt vector. Returns nullptr for
+ * vectors without IOAPIC, for example MSI and inter-processor
+ * interrupts. Implemented by the platform's IOAPIC module. */
+IOApicDef* findIOApic(uint64_t irq);
+
 } // namepsace mythos
@@ -81,6 +81,8 @@ namespace mythos {
     &irq_knop // 31
   };
 
+  IIrqHandler<cpu::ThreadState*>* irq_usernmi = nullptr;
+
   bool handle_bugirqs(cpu::KernelIRQFrame* ctx)
   {
     if (ctx->irq>=32) return false;
@@ -39,5 +39,9 @@ namespace mythos {
   extern IIrqHandler<cpu::KernelIRQFrame*>* irq_kernelbugs[32];
 
   bool handle_bugirqs(cpu::KernelIRQFrame* ctx);
+
+  /** optional handler for non-maskable interrupts from user mode. Without
+   * a handler, they are treated as trap of the current execution context. */
+  extern IIrqHandler<cpu::ThreadState*>* irq_usernmi;
   
 } // namespace mythos
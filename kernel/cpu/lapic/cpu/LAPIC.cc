@@ -132,6 +132,14 @@ void XApic::disableTimer() {
     write(REG_LVT_TIMER, read(REG_LVT_TIMER).timer_mode(ONESHOT).masked(1).vector(0));
 }
 
+void XApic::enablePerfCounterNMI() {
+    write(REG_LVT_PERFCNT, read(REG_LVT_PERFCNT).delivery_mode(MODE_NMI).masked(0).vector(0));
+}
+
+void XApic::disablePerfCounterNMI() {
+    write(REG_LVT_PERFCNT, read(REG_LVT_PERFCNT).masked(1));
+}
+
 XApic::Register XApic::edgeIPI(IrcDestinationShorthand dest, IcrDeliveryMode mode, uint8_t vec) {
       return Register().destination_shorthand(dest).level_triggered(0).level(1)
         .logical_destination(0).delivery_mode(mode).vector(vec)
@@ -62,6 +62,11 @@ namespace mythos {
     void enableTimer(uint8_t irq, bool periodic);
     void disableTimer();
 
+    /** deliver performance counter overflows as NMI. The processor masks
+     * the entry on each overflow, hence call again to re-arm it. */
+    void enablePerfCounterNMI();
+    void disablePerfCounterNMI();
+
   protected:
     Register edgeIPI(IrcDestinationShorthand dest, IcrDeliveryMode mode, uint8_t vec);
     Register read(size_t reg) { return lapic_base[reg/4]; }
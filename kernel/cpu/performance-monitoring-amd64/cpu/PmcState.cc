@@ -0,0 +1,168 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#include "cpu/PmcState.hh"
+#include "cpu/ctrlregs.hh"
+#include "objects/mlog.hh"
+
+namespace mythos {
+namespace cpu {
+
+static uint32_t num_pmcs = 0;
+static uint32_t num_fixed = 0;
+static uint64_t pmc_mask = 0;
+static uint64_t fixed_mask = 0;
+static bool full_width_write = false;
+static uint64_t reserved_mask = 0; // counters that are not owned by execution contexts
+
+void PmcState::initBSP()
+{
+  if (x86::maxLeave() < x86::ARCHITECTURAL_PERFORMANCE_MONTIROING_LEAF) return;
+  auto leaf = x86::cpuid(x86::ARCHITECTURAL_PERFORMANCE_MONTIROING_LEAF);
+  auto version = bits(leaf.eax, 7, 0);
+  if (version < 2) return; // no global control and fixed counters
+  num_pmcs = bits(leaf.eax, 15, 8);
+  if (num_pmcs > NUM_PMCS) num_pmcs = NUM_PMCS;
+  pmc_mask = (1ull << bits(leaf.eax, 23, 16)) - 1;
+  num_fixed = bits(leaf.edx, 4, 0);
+  if (num_fixed > NUM_FIXED) num_fixed = NUM_FIXED;
+  fixed_mask = (1ull << bits(leaf.edx, 12, 5)) - 1;
+  // PDCM: IA32_PERF_CAPABILITIES is present
+  if (bits(x86::cpuid(1).ecx, 15)) {
+    full_width_write = bits(x86::getMSR(x86::IA32_PERF_CAPABILITIES), 13);
+  }
+  MLOG_INFO(mlog::perfmon, "counters for execution contexts", DVAR(version),
+            DVAR(num_pmcs), DVAR(num_fixed), DVAR(full_width_write));
+}
+
+bool PmcState::available() { return num_pmcs > 0 || num_fixed > 0; }
+
+optional<size_t> PmcState::reserveCounter()
+{
+  if (num_pmcs == 0) THROW(Error::NOT_IMPLEMENTED);
+  num_pmcs--;
+  reserved_mask |= 1ull << num_pmcs;
+  MLOG_INFO(mlog::perfmon, "reserved counter", num_pmcs);
+  return size_t(num_pmcs);
+}
+
+void PmcState::clear()
+{
+  for (size_t i = 0; i < NUM_PMCS; i++) pmc[i] = evtsel[i] = pmcWritten[i] = 0;
+  for (size_t i = 0; i < NUM_FIXED; i++) fixed[i] = fixedWritten[i] = 0;
+  fixedCtrl = 0;
+  active = false;
+  userRead = false;
+}
+
+optional<void> PmcState::configure(uint64_t const* eventSelect, bool enableFixed, bool enableUserRead)
+{
+  if (!available()) THROW(Error::NOT_IMPLEMENTED);
+  clear();
+  for (size_t i = 0; i < NUM_PMCS; i++) {
+    if (!eventSelect[i]) continue;
+    if (i >= num_pmcs) THROW(Error::INVALID_ARGUMENT);
+    // keep just the event description, count only in user mode on this thread
+    x86::IA32_PERFEVTSELx_Bitfield sel(eventSelect[i]);
+    sel.usr = true;
+    sel.os = false;
+    sel.pc = false;
+    sel.intEn = false;
+    sel.anyThread = false;
+    sel.en = true;
+    evtsel[i] = sel;
+    active = true;
+  }
+  if (enableFixed) {
+    x86::IA32_FIXED_CTR_CTRL_Bitfield ctrl;
+    if (num_fixed > 0) ctrl.ff0_enable_user = true;
+    if (num_fixed > 1) ctrl.ff1_enable_user = true;
+    if (num_fixed > 2) ctrl.ff2_enable_user = true;
+    fixedCtrl = ctrl;
+    active = true;
+  }
+  userRead = enableUserRead && active;
+  RETURN(Error::SUCCESS);
+}
+
+void PmcState::restore()
+{
+  if (!active) return;
+  for (uint32_t i = 0; i < num_pmcs; i++) {
+    if (!evtsel[i]) continue;
+    // without full width writes only the lower 32 bits can be restored
+    if (full_width_write) {
+      pmcWritten[i] = pmc[i] & pmc_mask;
+      x86::setMSR(x86::IA32_A_PMC0 + i, pmcWritten[i]);
+    } else {
+      pmcWritten[i] = 0;
+      x86::setMSR(x86::IA32_PMC0 + i, 0);
+    }
+    x86::setMSR(x86::IA32_PERFEVTSEL0 + i, evtsel[i]);
+  }
+  if (fixedCtrl) {
+    for (uint32_t i = 0; i < num_fixed; i++) {
+      fixedWritten[i] = fixed[i] & fixed_mask;
+      x86::setMSR(x86::IA32_PERF_FIXED_CTR0 + i, fixedWritten[i]);
+    }
+    x86::setMSR(x86::IA32_FIXED_CTR_CTRL, fixedCtrl);
+  }
+  x86::setMSR(x86::IA32_PERF_GLOBAL_CTRL,
+              ((1ull << num_pmcs) - 1) | (((1ull << num_fixed) - 1) << 32) | reserved_mask);
+  if (userRead) x86::setCR4(x86::getCR4() | x86::PCE);
+}
+
+void PmcState::update()
+{
+  if (!active) return;
+  for (uint32_t i = 0; i < num_pmcs; i++) {
+    if (!evtsel[i]) continue;
+    auto value = x86::getMSR(x86::IA32_PMC0 + i);
+    pmc[i] += (value - pmcWritten[i]) & pmc_mask;
+    pmcWritten[i] = value;
+  }
+  if (fixedCtrl) {
+    for (uint32_t i = 0; i < num_fixed; i++) {
+      auto value = x86::getMSR(x86::IA32_PERF_FIXED_CTR0 + i);
+      fixed[i] += (value - fixedWritten[i]) & fixed_mask;
+      fixedWritten[i] = value;
+    }
+  }
+}
+
+void PmcState::save()
+{
+  if (!active) return;
+  // stop the counters first, then take over their final values
+  for (uint32_t i = 0; i < num_pmcs; i++) {
+    if (evtsel[i]) x86::setMSR(x86::IA32_PERFEVTSEL0 + i, 0);
+  }
+  if (fixedCtrl) x86::setMSR(x86::IA32_FIXED_CTR_CTRL, 0);
+  update();
+  if (userRead) x86::setCR4(x86::getCR4() & ~size_t(x86::PCE));
+}
+
+} // namespace cpu
+} // namespace mythos
@@ -0,0 +1,88 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "cpu/perfmondefs.hh"
+#include "util/optional.hh"
+#include "util/error-trace.hh"
+
+namespace mythos {
+  namespace cpu {
+
+    /** Performance monitoring counters of a single execution context.
+     *
+     * The counters count events in user mode only. The hardware counters are
+     * reprogrammed when the execution context is loaded and their progress is
+     * accumulated into 64bit values when it is saved. Execution contexts that
+     * never configured counters skip all MSR accesses.
+     */
+    class PmcState
+    {
+    public:
+      static constexpr size_t NUM_PMCS = x86::MAX_NUM_PMCS;
+      static constexpr size_t NUM_FIXED = x86::MAX_NUM_FIXED_CTRS;
+
+      /** called once during bootup to query the available counters. */
+      static void initBSP();
+      static bool available();
+
+      /** withdraw the highest general purpose counter from the execution
+       * contexts, for example for sampling. Call during boot before the
+       * first execution context is loaded. Returns the counter's index. */
+      static optional<size_t> reserveCounter();
+
+      /** program the general purpose counters with the given event
+       * selectors (0 for unused counters), enable the three fixed
+       * function counters, and allow RDPMC in user mode.
+       * Resets all accumulated counts. */
+      optional<void> configure(uint64_t const* eventSelect, bool fixed, bool userRead);
+
+      void clear();
+      void save();
+      void restore();
+
+      /** accumulate the progress of the loaded counters. */
+      void update();
+
+      bool isActive() const { return active; }
+
+    public:
+      uint64_t pmc[NUM_PMCS];
+      uint64_t fixed[NUM_FIXED];
+
+    protected:
+      uint64_t evtsel[NUM_PMCS];
+      uint64_t fixedCtrl;
+      uint64_t pmcWritten[NUM_PMCS]; // counter values at restore
+      uint64_t fixedWritten[NUM_FIXED];
+      bool active;
+      bool userRead;
+    };
+
+  } // namespace cpu
+} // namespace mythos
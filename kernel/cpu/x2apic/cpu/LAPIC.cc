@@ -101,6 +101,16 @@ void X2Apic::disableTimer() {
     x86::setMSR(REG_LVT_TIMER, reg.timer_mode(ONESHOT).masked(1).vector(0xFF));
 }
 
+void X2Apic::enablePerfCounterNMI() {
+    RegLVT reg(x86::getMSR(REG_LVT_PERFCNT));
+    x86::setMSR(REG_LVT_PERFCNT, reg.delivery_mode(MODE_NMI).masked(0).vector(0));
+}
+
+void X2Apic::disablePerfCounterNMI() {
+    RegLVT reg(x86::getMSR(REG_LVT_PERFCNT));
+    x86::setMSR(REG_LVT_PERFCNT, reg.masked(1));
+}
+
 void X2Apic::startupBroadcast(size_t startIP)
 {
     // send edge-triggered INIT
@@ -59,6 +59,11 @@ public: // public methods for mythos
     void enableTimer(uint8_t irq, bool periodic);
     void disableTimer();
 
+    /** deliver performance counter overflows as NMI. The processor masks
+     * the entry on each overflow, hence call again to re-arm it. */
+    void enablePerfCounterNMI();
+    void disablePerfCounterNMI();
+
 public: // plattform specific constants and types
 
     enum RegisterAddr {
@@ -139,6 +144,7 @@ public: // plattform specific constants and types
 
     BITFIELD_DEF(uint64_t, RegLVT)
     UIntField<value_t,base_t, 0,8> vector;
+    UIntField<value_t,base_t, 8,3> delivery_mode;
     BoolField<value_t,base_t, 13> pin_polarity;
     BoolField<value_t,base_t, 14> remote_irr;
     BoolField<value_t,base_t, 15> trigger_mode;
@@ -0,0 +1,119 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+/** Micro-benchmark of the kernel's string operations against the
+ * byte-wise loops they replaced and the host's C library.
+ */
+
+#include "util/mstring.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace mythos;
+
+static uint64_t rdtsc() {
+  uint32_t low, high;
+  asm volatile("rdtsc" : "=a" (low), "=d" (high));
+  return (uint64_t(high) << 32) | low;
+}
+
+static void* bytes_memcpy(void* dst, void const* src, size_t count) {
+  auto d = reinterpret_cast<char volatile*>(dst);
+  auto s = reinterpret_cast<char const*>(src);
+  for (size_t i = 0; i < count; i++) d[i] = s[i];
+  return dst;
+}
+
+static void* bytes_memset(void* dst, char value, size_t count) {
+  auto d = reinterpret_cast<char volatile*>(dst);
+  for (size_t i = 0; i < count; i++) d[i] = value;
+  return dst;
+}
+
+static int bytes_memcmp(void const* ptr1, void const* ptr2, size_t num) {
+  auto p1 = reinterpret_cast<unsigned char const volatile*>(ptr1);
+  auto p2 = reinterpret_cast<unsigned char const volatile*>(ptr2);
+  for (size_t i = 0; i < num; i++) {
+    if (p1[i] != p2[i]) return p1[i] < p2[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+template<class FUN>
+static double measure(size_t size, FUN fun) {
+  size_t rounds = size_t(64) * 1024 * 1024 / size + 1;
+  fun(); // warm up
+  auto start = rdtsc();
+  for (size_t i = 0; i < rounds; i++) fun();
+  return double(rdtsc() - start) / double(rounds);
+}
+
+int main()
+{
+  size_t const maxsize = size_t(4) * 1024 * 1024;
+  auto src = static_cast<char*>(aligned_alloc(4096, maxsize));
+  auto dst = static_cast<char*>(aligned_alloc(4096, maxsize));
+  ::memset(src, 1, maxsize);
+  ::memset(dst, 1, maxsize);
+  StringFeatures detected = stringFeatures;
+  printf("erms %d fsrm %d\n", detected.erms, detected.fsrm);
+  printf("%-7s%10s %12s %12s %12s %12s %12s\n", "op", "size", "bytes", "movsq", "erms", "nt", "libc");
+
+  volatile int sink = 0;
+  for (size_t size = 16; size <= maxsize; size *= 4) {
+    double base = measure(size, [&]{ bytes_memcpy(dst, src, size); });
+    stringFeatures = StringFeatures();
+    double words = measure(size, [&]{ mythos::memcpy(dst, src, size); });
+    stringFeatures.erms = stringFeatures.fsrm = true;
+    double erms = measure(size, [&]{ mythos::memcpy(dst, src, size); });
+    stringFeatures = detected;
+    double libc = measure(size, [&]{ ::memcpy(dst, src, size); });
+    printf("%-7s%10zu %12.1f %12.1f %12.1f %12s %12.1f\n", "memcpy", size, base, words, erms, "-", libc);
+  }
+  for (size_t size = 16; size <= maxsize; size *= 4) {
+    double base = measure(size, [&]{ bytes_memset(dst, 0, size); });
+    stringFeatures = StringFeatures();
+    double words = measure(size, [&]{ mythos::memset(dst, 0, size); });
+    stringFeatures.erms = stringFeatures.fsrm = true;
+    double erms = measure(size, [&]{ mythos::memset(dst, 0, size); });
+    stringFeatures = detected;
+    double nt = measure(size, [&]{ mythos::memzero_nt(dst, size); });
+    double libc = measure(size, [&]{ ::memset(dst, 0, size); });
+    printf("%-7s%10zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", "memset", size, base, words, erms, nt, libc);
+  }
+  ::memcpy(dst, src, maxsize);
+  for (size_t size = 16; size <= maxsize; size *= 4) {
+    double base = measure(size, [&]{ sink += bytes_memcmp(dst, src, size); });
+    double words = measure(size, [&]{ sink += mythos::memcmp(dst, src, size); });
+    double libc = measure(size, [&]{ sink += ::memcmp(dst, src, size); });
+    printf("%-7s%10zu %12.1f %12.1f %12s %12s %12.1f\n", "memcmp", size, base, words, "-", "-", libc);
+  }
+
+  free(src);
+  free(dst);
+  return 0;
+}
@@ -26,6 +26,7 @@
 #pragma once
 
 #include "mythos/InvocationBuf.hh"
+#include "mythos/LogRing.hh"
 
 #define PS_PER_TSC_DEFAULT (0x180)
 
@@ -41,11 +42,13 @@ class InfoFrame{
     InvocationBuf* getInvocationBuf() {return &ib; }
     uint64_t getPsPerTSC() { return psPerTsc; }
     size_t getNumThreads() { return numThreads; }
+    LogRing* getLogRing() { return &log; }
     uintptr_t getInfoEnd () { return reinterpret_cast<uintptr_t>(this) + sizeof(InfoFrame); }
 
     InvocationBuf ib; // needs to be the first member (see Initloader::createPortal)
     uint64_t psPerTsc; // picoseconds per time stamp counter
     size_t numThreads; // number of hardware threads available in the system
+    LogRing log; // buffered output of the process
 };
 
 } // namespace mythos
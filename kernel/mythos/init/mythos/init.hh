@@ -58,6 +58,7 @@ namespace init {
     INFO_FRAME,
     INTERRUPT_CONTROL_START,
     INTERRUPT_CONTROL_END = INTERRUPT_CONTROL_START+256,
+    PMU_SAMPLES,
     APP_CAP_START = 1024,
     SIZE = 4096
   };
@@ -26,7 +26,9 @@
 #pragma once
 
 #include "mythos/protocol/KernelMemory.hh"
+#include "mythos/protocol/PageMap.hh"
 #include "mythos/protocol/common.hh"
+#include "mythos/KEvent.hh"
 
 namespace mythos {
   namespace protocol {
@@ -40,7 +42,11 @@ namespace mythos {
         WRITE_REGISTERS,
         SET_FSGS,
         RESUME,
-        SUSPEND
+        SUSPEND,
+        CONFIGURE_COUNTERS,
+        READ_COUNTERS,
+        SET_PAGER,
+        RESOLVE_FAULT
       };
 
       enum Signals : uint64_t {
@@ -135,6 +141,99 @@ namespace mythos {
         Suspend() : InvocationBase(label,getLength(this)) {}
       };
 
+      /** programs the performance monitoring counters of the EC. They
+       * count only while the EC runs in user mode. The event selectors
+       * follow the layout of IA32_PERFEVTSELx, 0 leaves a counter unused. */
+      struct ConfigureCounters : public InvocationBase {
+        constexpr static uint16_t label = (proto<<8) + CONFIGURE_COUNTERS;
+        constexpr static size_t NUM_PMCS = 4;
+        ConfigureCounters(uint64_t const* eventSelect, bool fixed, bool userRead)
+          : InvocationBase(label,getLength(this)), fixed(fixed), userRead(userRead)
+        {
+          for (size_t i = 0; i < NUM_PMCS; i++) this->eventSelect[i] = eventSelect[i];
+        }
+        uint64_t eventSelect[NUM_PMCS];
+        bool fixed; // instructions retired, unhalted core and reference cycles
+        bool userRead; // allow RDPMC while the EC is running
+      };
+
+      // has Counters message as result
+      struct ReadCounters : public InvocationBase {
+        constexpr static uint16_t label = (proto<<8) + READ_COUNTERS;
+        ReadCounters() : InvocationBase(label,getLength(this)) {}
+      };
+
+      struct Counters : public InvocationBase {
+        constexpr static uint16_t label = (proto<<8) + READ_COUNTERS;
+        constexpr static size_t NUM_PMCS = ConfigureCounters::NUM_PMCS;
+        constexpr static size_t NUM_FIXED = 3;
+        Counters() : InvocationBase(label,getLength(this)) {}
+        uint64_t pmc[NUM_PMCS];
+        uint64_t fixed[NUM_FIXED];
+      };
+
+      /** page faults in the user half of the address space are sent to
+       * the pager's KEvent queue instead of trapping with TRAP_PAGEFAULT.
+       * The KEvent carries the context and the encoded PageFault. The EC
+       * stays suspended until ResolveFault or Resume. delete_cap removes
+       * the pager. */
+      struct SetPager : public InvocationBase {
+        constexpr static uint16_t label = (proto<<8) + SET_PAGER;
+        SetPager(CapPtr pager, KEvent::Context context)
+          : InvocationBase(label,getLength(this)), context(context)
+        {
+          addExtraCap(pager);
+        }
+        CapPtr pager() const { return this->capPtrs[0]; }
+        KEvent::Context context;
+      };
+
+      /** KEvent value of a forwarded page fault: the faulting address in
+       * the lower 48 bits and the hardware error code above. */
+      struct PageFault {
+        constexpr static unsigned ERROR_SHIFT = 48;
+        constexpr static uint64_t ADDR_MASK = (1ull << ERROR_SHIFT) - 1;
+        constexpr static uint64_t USER_END = 1ull << 47;
+
+        PageFault(KEvent::Value value) : addr(value & ADDR_MASK), error(value >> ERROR_SHIFT) {}
+        static bool forwardable(uintptr_t addr) { return addr < USER_END; }
+        static KEvent::Value encode(uintptr_t addr, uint64_t error) {
+          return (addr & ADDR_MASK) | (error << ERROR_SHIFT);
+        }
+
+        bool present() const { return error & 0x1; } // protection violation, not a missing page
+        bool write() const { return error & 0x2; }
+        bool instruction() const { return error & 0x10; }
+        /** a write to a present page without other causes, such as reserved bits */
+        bool protectedWrite() const { return (error & ~uint64_t(0x4)) == 0x3; }
+
+        uintptr_t addr;
+        uint64_t error;
+      };
+
+      /** maps the frame like PageMap::Mmap and resumes the EC if that
+       * succeeded. Without page map it resumes only. The reply is a
+       * PageMap::Result. */
+      struct ResolveFault : public InvocationBase {
+        typedef PageMap::MapFlags MapFlags;
+        constexpr static uint16_t label = (proto<<8) + RESOLVE_FAULT;
+        ResolveFault(CapPtr pagemap, CapPtr frame, uintptr_t vaddr, size_t size,
+                     MapFlags flags, size_t offset)
+          : InvocationBase(label,getLength(this)), vaddr(vaddr), size(size),
+            flags(flags), offset(offset)
+        {
+          addExtraCap(pagemap);
+          addExtraCap(frame);
+        }
+        ResolveFault() : ResolveFault(null_cap, null_cap, 0, 0, MapFlags(), 0) {}
+        CapPtr pagemap() const { return this->capPtrs[0]; }
+        CapPtr frame() const { return this->capPtrs[1]; }
+        uintptr_t vaddr;
+        size_t size;
+        MapFlags flags;
+        size_t offset;
+      };
+
       struct Create : public KernelMemory::CreateBase {
         typedef InvocationBase response_type;
         Create(CapPtr dst, CapPtr factory) 
@@ -158,6 +257,10 @@ namespace mythos {
         case SET_FSGS: return obj->invokeSetFSGS(args...);
         case RESUME: return obj->invokeResume(args...);
         case SUSPEND: return obj->invokeSuspend(args...);
+        case CONFIGURE_COUNTERS: return obj->invokeConfigureCounters(args...);
+        case READ_COUNTERS: return obj->invokeReadCounters(args...);
+        case SET_PAGER: return obj->invokeSetPager(args...);
+        case RESOLVE_FAULT: return obj->invokeResolveFault(args...);
         default: return Error::NOT_IMPLEMENTED;
         }
       }
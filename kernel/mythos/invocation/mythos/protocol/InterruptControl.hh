@@ -39,8 +39,14 @@ namespace mythos {
         UNREGISTER,
         MASK_IRQ,
         UNMASK_IRQ,
+        ACKNOWLEDGE,
       };
 
+      /** Registering at the interrupt controller of a hardware thread
+       * routes the interrupt to this hardware thread if it comes from an
+       * IOAPIC. The destination is signalled once per batch of interrupts
+       * until the batch is acknowledged or the interrupt is unmasked.
+       */
       struct Register : public InvocationBase {
         typedef InvocationBase response_type;
         constexpr static uint16_t label = (proto<<8) + REGISTER;
@@ -77,6 +83,21 @@ namespace mythos {
         uint32_t interrupt;
       };
 
+      /** returns the number of interrupts since the last acknowledge,
+       * unmasks the interrupt and re-arms the signal. */
+      struct Acknowledge : public InvocationBase {
+        constexpr static uint16_t label = (proto<<8) + ACKNOWLEDGE;
+        Acknowledge(uint32_t interrupt)
+          : InvocationBase(label,getLength(this)), interrupt(interrupt) { }
+        uint32_t interrupt;
+      };
+
+      struct Pending : public InvocationBase {
+        constexpr static uint16_t label = (proto<<8) + ACKNOWLEDGE;
+        Pending() : InvocationBase(label,getLength(this)) { }
+        uint32_t count = 0;
+      };
+
 
 
       template<class IMPL, class... ARGS>
@@ -86,6 +107,7 @@ namespace mythos {
         case UNREGISTER: return obj->unregisterInterrupt(args...);
         case MASK_IRQ:    return obj->maskIRQ(args...);
         case UNMASK_IRQ:    return obj->unmaskIRQ(args...);
+        case ACKNOWLEDGE:    return obj->acknowledge(args...);
         default: return Error::NOT_IMPLEMENTED;
         }
       }
@@ -43,7 +43,9 @@ namespace mythos {
         UNMAP,
         INSTALLMAP,
         REMOVEMAP,
-        RESULT
+        RESULT,
+        MAPMANY,
+        SETCOWPOOL
       };
 
       BITFIELD_DEF(CapRequest, PageMapReq)
@@ -57,6 +59,7 @@ namespace mythos {
       BoolField<value_t,base_t,2> cache_disabled;
       BoolField<value_t,base_t,3> write_through;
       BoolField<value_t,base_t,4> configurable;
+      BoolField<value_t,base_t,5> copy_on_write; // writable mappings: read-only until the first write, which maps a private copy
       MapFlags() : value(0) {}
       BITFIELD_END
 
@@ -96,6 +99,74 @@ namespace mythos {
         size_t offset;
       };
 
+      /** Maps a batch of frames with a single invocation. Page maps that
+       * are missing on the way are allocated from the kernel memory and
+       * stored in the empty capability slots that were passed with
+       * addTable(). They are installed with tableFlags, which should
+       * include configurable so that the later mappings can pass through.
+       */
+      struct MmapMany : public InvocationBase {
+        constexpr static uint16_t label = (proto << 8) + MAPMANY;
+
+        struct Mapping {
+          uintptr_t vaddr;
+          size_t size;
+          size_t offset;
+          CapPtr frame;
+          MapFlags flags;
+        };
+        constexpr static size_t MAX_MAPPINGS = 14;
+
+        MmapMany(CapPtr kmem, MapFlags tableFlags)
+          : InvocationBase(label, getLength(this)), count(0), tableFlags(tableFlags)
+        {
+          addExtraCap(kmem);
+        }
+
+        /** appends a mapping, returns false if the message is full. */
+        bool add(CapPtr frame, uintptr_t vaddr, size_t size, MapFlags flags, size_t offset=0) {
+          if (count >= MAX_MAPPINGS) return false;
+          auto& m = mappings[count++];
+          m.vaddr = vaddr;
+          m.size = size;
+          m.offset = offset;
+          m.frame = frame;
+          m.flags = flags;
+          return true;
+        }
+
+        /** offers an empty slot for a new page map, returns false if all extra caps are used. */
+        bool addTable(CapPtr slot) {
+          if (tag.extra_caps >= 6) return false;
+          addExtraCap(slot);
+          return true;
+        }
+
+        CapPtr kmem() const { return capPtrs[0]; }
+        size_t numTables() const { return tag.extra_caps-1; }
+        CapPtr table(size_t i) const { return capPtrs[1+i]; }
+        uint32_t count;
+        MapFlags tableFlags;
+        Mapping mappings[MAX_MAPPINGS];
+      };
+
+      /** sets the frame that provides the private copies of
+       * copy-on-write pages in this address space. The pages are
+       * allocated from the frame one after the other. Unmapping a
+       * private copy does not return its page to the pool, thus the
+       * frame has to hold all copies of the address space's lifetime.
+       * Setting a pool starts again at the frame's beginning, hence a
+       * frame must not be set again while copies from it are mapped.
+       * null_cap removes the pool. */
+      struct SetCowPool : public InvocationBase {
+        constexpr static uint16_t label = (proto << 8) + SETCOWPOOL;
+        SetCowPool(CapPtr frame) : InvocationBase(label, getLength(this))
+        {
+          addExtraCap(frame);
+        }
+        CapPtr frame() const { return capPtrs[0]; }
+      };
+
       struct Remap : public InvocationBase {
         constexpr static uint16_t label = (proto << 8) + REMAP;
         Remap(uintptr_t sourceAddr, uintptr_t destAddr, size_t size)
@@ -142,6 +213,18 @@ namespace mythos {
         size_t level;
       };
 
+      /** reply to MmapMany: the fail address and level refer to the
+       * first mapping that could not be completed. */
+      struct MmapManyResult : public Result {
+        MmapManyResult(uintptr_t vaddr, size_t level, uint32_t mapped, uint32_t tables)
+          : Result(vaddr, level), mapped(mapped), tables(tables)
+        {
+          setLength(this);
+        }
+        uint32_t mapped;
+        uint32_t tables;
+      };
+
       template<class IMPL, class... ARGS>
       static Error dispatchRequest(IMPL* obj, uint8_t m, ARGS const&...args) {
 	switch(Methods(m)) {
@@ -151,6 +234,8 @@ namespace mythos {
 	case PROTECT: return obj->invokeMprotect(args...);
         case INSTALLMAP: return obj->invokeInstallMap(args...);
         case REMOVEMAP: return obj->invokeRemoveMap(args...);
+        case MAPMANY: return obj->invokeMmapMany(args...);
+        case SETCOWPOOL: return obj->invokeSetCowPool(args...);
 	default: return Error::NOT_IMPLEMENTED;
 	}
       }
@@ -40,7 +40,8 @@ namespace mythos {
     SYSCALL_INVOKE_POLL,
     SYSCALL_INVOKE_WAIT,
     SYSCALL_DEBUG,
-    SYSCALL_SIGNAL
+    SYSCALL_SIGNAL,
+    SYSCALL_DEBUG_RING
   };
 
   /** do a syscall according to mythos x86-64 system call convention
@@ -67,6 +68,12 @@ namespace mythos {
     syscall(mythos::SYSCALL_DEBUG, (uint64_t)start, length, 0);
   }
 
+  /** asks the kernel to write out the process' LogRing */
+  inline void syscall_debug_ring(void* ring)
+  {
+    syscall(mythos::SYSCALL_DEBUG_RING, (uint64_t)ring, 0, 0);
+  }
+
   inline KEvent syscall_poll()
   {
     return syscall(mythos::SYSCALL_POLL, 0, 0, 0);
@@ -0,0 +1,152 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace mythos {
+
+  /** Log output of one process. Any number of threads append records
+   * without entering the kernel, the kernel writes them in order to its
+   * log sink. The position at which a record was reserved is its
+   * sequence number: records are drained strictly in reservation order
+   * and a record counts as complete once its commit field holds its
+   * position plus one. Records never wrap around the end of the storage,
+   * a padding record fills the gap instead.
+   *
+   * The ring is placed in the process' info frame. The owner asks the
+   * kernel to drain it with syscall_debug_ring() when the ring is half
+   * full, when FLUSH_CYCLES elapsed since the last drain, or when it
+   * needs the space. Idle hardware threads drain the ring of the init
+   * application on their own.
+   */
+  struct LogRing
+  {
+    enum : size_t {
+      SIZE = 1ull << 16, //< bytes of record storage
+      ALIGN = 16,
+      MAX_RECORD = SIZE/4
+    };
+    enum : uint64_t { FLUSH_CYCLES = 1ull << 24 };
+    enum Flags : uint32_t { PADDING = 1 };
+
+    struct Record
+    {
+      std::atomic<uint64_t> commit; //< position+1 when complete
+      uint32_t length; //< bytes of text following the record header
+      uint32_t flags;
+      char* text() { return reinterpret_cast<char*>(this+1); }
+    };
+
+    enum : size_t { MAX_TEXT = MAX_RECORD - sizeof(Record) };
+
+    LogRing() : head(0), tail(0), drained(0), draining(false) {
+      __builtin_memset(data, 0, sizeof(data));
+    }
+
+    static uint64_t recordSize(size_t length) {
+      return (sizeof(Record) + length + ALIGN - 1) & ~(ALIGN - 1);
+    }
+
+    Record* record(uint64_t pos) { return reinterpret_cast<Record*>(&data[pos % SIZE]); }
+
+    size_t fill() const {
+      return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+    }
+
+    bool needsDrain(uint64_t now) const {
+      auto f = fill();
+      return f != 0 && (f >= SIZE/2
+          || now - drained.load(std::memory_order_relaxed) >= FLUSH_CYCLES);
+    }
+
+    /** appends up to MAX_TEXT bytes as one record.
+     *
+     * @return the number of bytes taken, 0 if the ring is full.
+     */
+    size_t push(char const* str, size_t length) {
+      if (length > MAX_TEXT) length = MAX_TEXT;
+      auto size = recordSize(length);
+      auto pos = head.load(std::memory_order_relaxed);
+      uint64_t skip;
+      do {
+        skip = (pos % SIZE + size > SIZE) ? SIZE - pos % SIZE : 0;
+        if (pos + skip + size - tail.load(std::memory_order_acquire) > SIZE) return 0;
+      } while (!head.compare_exchange_weak(pos, pos + skip + size, std::memory_order_relaxed));
+      if (skip) {
+        auto pad = record(pos);
+        pad->length = 0;
+        pad->flags = PADDING;
+        pad->commit.store(pos+1, std::memory_order_release);
+        pos += skip;
+      }
+      auto r = record(pos);
+      r->length = uint32_t(length);
+      r->flags = 0;
+      __builtin_memcpy(r->text(), str, length);
+      r->commit.store(pos+1, std::memory_order_release);
+      return length;
+    }
+
+    /** passes the complete records in order to sink(char const*, size_t)
+     * and releases their space. Stops at the first incomplete record. A
+     * record with an impossible size discards everything reserved so far.
+     *
+     * @return false if somebody else is draining the ring already.
+     */
+    template<class SINK>
+    bool drain(SINK sink) {
+      if (draining.exchange(true, std::memory_order_acquire)) return false;
+      auto pos = tail.load(std::memory_order_relaxed);
+      auto end = head.load(std::memory_order_acquire);
+      while (pos != end) {
+        auto r = record(pos);
+        if (r->commit.load(std::memory_order_acquire) != pos+1) break;
+        auto room = SIZE - pos % SIZE;
+        bool pad = r->flags & PADDING;
+        if (!pad && r->length > MAX_TEXT) { pos = end; break; }
+        auto size = pad ? room : recordSize(r->length);
+        if (size > room || size > end - pos) { pos = end; break; }
+        if (!pad) sink(r->text(), size_t(r->length));
+        pos += size;
+        tail.store(pos, std::memory_order_release);
+      }
+      tail.store(pos, std::memory_order_release);
+      drained.store(__builtin_ia32_rdtsc(), std::memory_order_relaxed);
+      draining.store(false, std::memory_order_release);
+      return true;
+    }
+
+    alignas(64) std::atomic<uint64_t> head; //< end of the reserved records
+    alignas(64) std::atomic<uint64_t> tail; //< begin of the undrained records
+    std::atomic<uint64_t> drained; //< time stamp counter at the last drain
+    std::atomic<bool> draining;
+    alignas(64) char data[SIZE];
+  };
+
+} // namespace mythos
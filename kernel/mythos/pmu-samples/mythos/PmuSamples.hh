@@ -0,0 +1,107 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace mythos {
+
+  /** One sample of the PMU profiler, taken when the sampling counter
+   * overflows on a hardware thread. */
+  struct PmuSample
+  {
+    enum : size_t { STACK_DEPTH = 5 };
+    enum Flags : uint64_t { USER = 1 };
+
+    uint64_t rip; //< interrupted instruction
+    uint64_t ec; //< kernel address of the current execution context, 0 if none
+    uint64_t flags;
+    uint64_t stack[STACK_DEPTH]; //< return addresses of the interrupted kernel code
+  };
+
+  /** Samples of one hardware thread. The kernel appends at head from the
+   * overflow interrupt, a single reader in user mode consumes at tail.
+   * Samples are counted as dropped while the ring is full. */
+  struct PmuSampleRing
+  {
+    enum : size_t {
+      SIZE = 1ull << 16,
+      CAPACITY = SIZE/sizeof(PmuSample) - 1
+    };
+
+    bool empty() const {
+      return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+    }
+    PmuSample const& front() const {
+      return samples[tail.load(std::memory_order_relaxed) % CAPACITY];
+    }
+    void pop() { tail.store(tail.load(std::memory_order_relaxed)+1, std::memory_order_release); }
+
+    /** called by the kernel on the owning hardware thread only. */
+    bool push(PmuSample const& s) {
+      auto h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+        dropped.store(dropped.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+        return false;
+      }
+      samples[h % CAPACITY] = s;
+      head.store(h+1, std::memory_order_release);
+      return true;
+    }
+
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+    uint64_t padding[sizeof(PmuSample)/sizeof(uint64_t) - 3];
+    PmuSample samples[CAPACITY];
+  };
+
+  /** Layout of the profiler's frame: a header followed by one ring per
+   * hardware thread. */
+  struct PmuSampleBuffer
+  {
+    enum : size_t { HEADER_SIZE = 1ull << 12 };
+
+    static size_t size(size_t numThreads) {
+      return HEADER_SIZE + numThreads * sizeof(PmuSampleRing);
+    }
+
+    PmuSampleRing* ring(size_t threadID) {
+      return reinterpret_cast<PmuSampleRing*>(
+          reinterpret_cast<char*>(this) + HEADER_SIZE) + threadID;
+    }
+
+    uint64_t numThreads;
+    uint64_t eventSelect; //< event that is counted by the sampling counter
+    uint64_t period; //< number of events between two samples
+  };
+
+  static_assert(sizeof(PmuSample) == 64, "samples should fill a cache line");
+  static_assert(sizeof(PmuSampleRing) == PmuSampleRing::SIZE, "unexpected ring size");
+
+} // namespace mythos
@@ -71,8 +71,7 @@ namespace mythos {
       monitor.requestDone();
       return;
     }
-    _result = _delete(&entry, entry.cap()).state();
-    _startAsyncDelete(t);
+    _continue(t, &entry, entry.cap());
   }
 
   void RevokeOperation::_revoke(Tasklet* t, result_t* res, CapEntry& entry, IKernelObject* guarded)
@@ -100,47 +99,76 @@ namespace mythos {
     // all children have been deleted in the mean time and we are done
     entry.setRevoking();
     entry.unlock();
-    _result = _delete(&entry, rootCap).state();
-    _startAsyncDelete(t);
+    _continue(t, &entry, rootCap);
   }
 
-  optional<void> RevokeOperation::_delete(CapEntry* root, Cap rootCap)
+  void RevokeOperation::_continue(Tasklet* t, CapEntry* root, Cap rootCap)
   {
-    CapEntry* leaf;
-    do {
-      if (_startTraversal(root, rootCap)) {
-        leaf = _findLockedLeaf(root);
-        MLOG_DETAIL(mlog::cap, "_findLockedLeaf returned", DVAR(*leaf), DVAR(rootCap));
-        if (leaf == root && !rootCap.isZombie()) {
-          // this is a revoke, do not delete the root. no more children -> we are done
-          root->finishRevoke();
-          root->unlock();
-          root->unlock_prev();
-          RETURN(Error::SUCCESS);
-        }
-        auto leafCap = leaf->cap();
-        ASSERT(leafCap.isZombie());
-        if (leafCap.getPtr() == _guarded) {
-          leaf->unlock();
-          leaf->unlock_prev();
-          // attempted to delete guarded object
-          THROW(Error::CYCLIC_DEPENDENCY);
-        }
-        auto delRes = leafCap.getPtr()->deleteCap(*leaf, leafCap, *this);
-        if (delRes) {
-          leaf->unlink();
-          leaf->reset();
-        } else {
-          // Either tried to delete a portal that is currently deleting
-          // or tried to to delete _guarded via a recursive call.
-          leaf->unlock();
-          leaf->unlock_prev();
-          RETHROW(delRes);
-        }
-      } else RETURN(Error::SUCCESS); // could not restart, must be done
-    } while (leaf != root);
-    // deleted root
-    RETURN(Error::SUCCESS);
+    _result = _delete(root, rootCap, BATCH_SIZE).state();
+    if (_result == Error::RETRY) {
+      // keep the monitor and let other tasks of this place run in between
+      MLOG_DETAIL(mlog::cap, "revocation yields", DVAR(*root));
+      getLocalPlace().runBulk(t->set([this, root, rootCap](Tasklet* t){
+            _continue(t, root, rootCap);
+          }));
+    } else {
+      _startAsyncDelete(t);
+    }
+  }
+
+  optional<void> RevokeOperation::_delete(CapEntry* root, Cap rootCap, size_t budget)
+  {
+    // The path from the root to the current leaf is a contiguous
+    // sequence in the list because the traversal always follows next.
+    // Hence, the leaf's prev is its parent and the traversal resumes
+    // there instead of restarting at the root. The parent is revalidated
+    // by _startTraversal just like the root.
+    auto start = root;
+    auto startCap = rootCap;
+    while (true) {
+      if (!_startTraversal(start, startCap)) {
+        if (start == root) RETURN(Error::SUCCESS); // could not restart, must be done
+        // the parent was removed concurrently, restart from the root
+        start = root;
+        startCap = rootCap;
+        continue;
+      }
+      auto leaf = _findLockedLeaf(start);
+      MLOG_DETAIL(mlog::cap, "_findLockedLeaf returned", DVAR(*leaf), DVAR(rootCap));
+      if (leaf == root && !rootCap.isZombie()) {
+        // this is a revoke, do not delete the root. no more children -> we are done
+        root->finishRevoke();
+        root->unlock();
+        root->unlock_prev();
+        RETURN(Error::SUCCESS);
+      }
+      auto leafCap = leaf->cap();
+      ASSERT(leafCap.isZombie());
+      if (leafCap.getPtr() == _guarded) {
+        leaf->unlock();
+        leaf->unlock_prev();
+        // attempted to delete guarded object
+        THROW(Error::CYCLIC_DEPENDENCY);
+      }
+      // the link to the parent is locked, thus its capability is stable
+      auto parent = leaf->prev();
+      auto parentCap = parent->cap();
+      auto delRes = leafCap.getPtr()->deleteCap(*leaf, leafCap, *this);
+      if (delRes) {
+        leaf->unlink();
+        leaf->reset();
+      } else {
+        // Either tried to delete a portal that is currently deleting
+        // or tried to to delete _guarded via a recursive call.
+        leaf->unlock();
+        leaf->unlock_prev();
+        RETHROW(delRes);
+      }
+      if (leaf == root) RETURN(Error::SUCCESS); // deleted root
+      if (--budget == 0) THROW(Error::RETRY); // yield, the caller resumes at the root
+      start = parent;
+      startCap = parentCap;
+    }
   }
 
   bool RevokeOperation::_startTraversal(CapEntry* root, Cap rootCap)
@@ -29,7 +29,7 @@
 #include "util/assert.hh"
 #include "util/LinkedList.hh"
 #include "async/IResult.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/IKernelObject.hh"
 #include "objects/CapEntry.hh"
 #include "objects/DeleteBroadcast.hh"
@@ -48,7 +48,7 @@ public:
   typedef IResult<void> result_t;
   typedef LinkedList<IKernelObject*> queue_t;
 
-  RevokeOperation(async::NestedMonitorDelegating& m) : monitor(m), _res(nullptr) {}
+  RevokeOperation(async::ObjectMonitor& m) : monitor(m), _res(nullptr) {}
   RevokeOperation(const RevokeOperation&) = delete;
   virtual ~RevokeOperation() {}
 
@@ -100,20 +100,27 @@ public:
     _lock.clear();
   };
 
+  /** maximal number of entries deleted before yielding to the place */
+  static constexpr size_t BATCH_SIZE = 64;
+
 private:
   friend class ProcessorAllocator; //need to directly access _revoke in deallocation sequence (todo: do it better!)
   void _revoke(Tasklet* t, result_t* res, CapEntry& entry, IKernelObject* guarded);
   void _delete(Tasklet* t, result_t* res, CapEntry& entry, IKernelObject* guarded);
   void _deleteObject(Tasklet* t);
+  void _continue(Tasklet* t, CapEntry* root, Cap rootCap);
 
-  optional<void> _delete(CapEntry* root, Cap rootCap);
+  /** deletes the subtree below root in a single pass and the root
+   * itself if it is a zombie. Stops with Error::RETRY after budget
+   * deleted entries, then the caller has to call again. */
+  optional<void> _delete(CapEntry* root, Cap rootCap, size_t budget = SIZE_MAX);
   bool _startTraversal(CapEntry* root, Cap rootCap);
   CapEntry* _findLockedLeaf(CapEntry* root);
 
   void _startAsyncDelete(Tasklet* t);
 
 private:
-  async::NestedMonitorDelegating& monitor;
+  async::ObjectMonitor& monitor;
   /// FIFO ... this way, every object apears before its parents
   /// and can be deleted (avoids intraprocess/object snychronization)
   /// children might be in another list, but these can be waited for
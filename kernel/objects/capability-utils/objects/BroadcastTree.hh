@@ -0,0 +1,157 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include <atomic>
+#include "async/Place.hh"
+#include "async/Tasklet.hh"
+#include "cpu/hwthreadid.hh"
+
+namespace mythos {
+
+/** Fan-out/fan-in broadcast over the places of all hardware threads.
+ *
+ * The nodes form a FANOUT-ary tree over the hardware threads sorted
+ * by their APIC ID. Each subtree covers a contiguous range of this
+ * order, which keeps the threads of a core or package close together
+ * in the tree. A round reaches all places in O(log n) hops instead of
+ * relaying around a ring.
+ *
+ * The derived class NODE provides the static array of nodes and
+ * implements:
+ *  - bool mustVisit() const: whether the node's place has to be visited,
+ *  - void visitLocal(): the work to do on the node's place, and
+ *  - static void finished(): called on the last place when the round is done.
+ *
+ * Subtrees of places that need no visit are traversed in bulk by the
+ * place that would have sent the message. The visits are queued in the
+ * places' normal FIFO queue, thus a visit runs only after all tasks
+ * that were queued on its place before. The grace periods of
+ * DeleteBroadcast rely on this order. Only one round may be in flight
+ * at a time because each node has just one tasklet.
+ */
+template<class NODE>
+class BroadcastTree
+{
+public:
+  static constexpr size_t FANOUT = 4;
+
+  BroadcastTree() : home(nullptr), upstream(nullptr), numChildren(0), pending(0) {}
+
+protected:
+  static void initTree(NODE* nodes);
+
+  /** starts a round on the calling place */
+  static void startRound() {
+    sentinel.pending.store(1);
+    sentinel.spread(&sentinel);
+    sentinel.done();
+  }
+
+private:
+  void visit() {
+    pending.store(1);
+    spread(this);
+    static_cast<NODE*>(this)->visitLocal();
+    done();
+  }
+
+  /** sends the visit to the children or handles their subtree in bulk.
+   * The visited children report to the target. */
+  void spread(BroadcastTree* target) {
+    for (size_t i = 0; i < numChildren; i++) {
+      auto c = children[i];
+      if (static_cast<NODE*>(c)->mustVisit()) {
+        target->pending.fetch_add(1);
+        c->upstream = target;
+        c->home->run(c->tasklet.set([c](Tasklet*){ c->visit(); }));
+      } else c->spread(target);
+    }
+  }
+
+  /** builds the subtree over order[begin..end), the first thread is its root */
+  static BroadcastTree* build(NODE* nodes, cpu::ThreadID const* order, size_t begin, size_t end);
+
+  void done() {
+    if (pending.fetch_sub(1) != 1) return;
+    if (this == &sentinel) NODE::finished();
+    else upstream->done();
+  }
+
+protected:
+  async::Place* home;
+
+private:
+  BroadcastTree* upstream; //< the nearest visited ancestor in the current round
+  BroadcastTree* children[FANOUT];
+  size_t numChildren;
+  std::atomic<size_t> pending; //< own visit plus visited descendants that did not report yet
+  Tasklet tasklet;
+  static BroadcastTree sentinel; //< virtual parent of the root
+};
+
+template<class NODE>
+BroadcastTree<NODE> BroadcastTree<NODE>::sentinel;
+
+template<class NODE>
+void BroadcastTree<NODE>::initTree(NODE* nodes)
+{
+  // sort the thread ids by APIC ID, neighbours share cores and packages
+  cpu::ThreadID order[MYTHOS_MAX_THREADS];
+  auto n = cpu::getNumThreads();
+  for (size_t i = 0; i < n; i++) {
+    auto id = cpu::ThreadID(i);
+    auto apic = async::getPlace(id)->getApicID();
+    size_t pos = i;
+    for (; pos > 0 && async::getPlace(order[pos-1])->getApicID() > apic; pos--) {
+      order[pos] = order[pos-1];
+    }
+    order[pos] = id;
+  }
+
+  sentinel.numChildren = 0;
+  if (n > 0) sentinel.children[sentinel.numChildren++] = build(nodes, order, 0, n);
+}
+
+template<class NODE>
+BroadcastTree<NODE>* BroadcastTree<NODE>::build(NODE* nodes, cpu::ThreadID const* order,
+                                                size_t begin, size_t end)
+{
+  BroadcastTree* node = &nodes[order[begin]];
+  node->home = async::getPlace(order[begin]);
+  node->numChildren = 0;
+  // split the remaining range into FANOUT contiguous parts of nearly equal size
+  size_t rest = end - begin - 1;
+  size_t first = begin + 1;
+  for (size_t c = 0; c < FANOUT && first < end; c++) {
+    size_t last = first + (rest + FANOUT - 1 - c) / FANOUT;
+    node->children[node->numChildren++] = build(nodes, order, first, last);
+    first = last;
+  }
+  return node;
+}
+
+} // namespace mythos
@@ -31,34 +31,60 @@
 namespace mythos {
 
   DeleteBroadcast DeleteBroadcast::nodes[MYTHOS_MAX_THREADS];
+  async::TaskletQueue DeleteBroadcast::waiting;
+  async::TaskletBase* DeleteBroadcast::batch = nullptr;
+  uint64_t DeleteBroadcast::target = 0;
+  Tasklet DeleteBroadcast::finisher;
 
   void DeleteBroadcast::init()
   {
-    for (cpu::ThreadID id = 0; id < cpu::getNumThreads(); ++id) {
-      /// @todo not needed with linear thread id!
-      nodes[id].next = &nodes[(id+1)%cpu::getNumThreads()];
-      nodes[id].home = async::getPlace(id);
-    }
+    initTree(nodes);
   }
 
   void DeleteBroadcast::run(Tasklet* t, IResult<void>* res)
   {
-    MLOG_DETAIL(mlog::cap, "start delete broadcast");
-    DeleteBroadcast* start = &nodes[cpu::getThreadID()];
-    start->broadcast(t, res, start);
+    t->set([res](Tasklet* t) { res->response(t); });
+    if (waiting.push(*t)) { // first request, no grace period in progress
+      startGracePeriod();
+    } // else the current grace period will start the next one
+  }
+
+  void DeleteBroadcast::startGracePeriod()
+  {
+    // all requests that arrived so far are covered by this grace period
+    ASSERT(batch == nullptr);
+    size_t count = 0;
+    for (auto t = waiting.pull(); t != nullptr; t = waiting.pull()) {
+      t->next.store(reinterpret_cast<uintptr_t>(batch), std::memory_order_relaxed);
+      batch = t;
+      count++;
+    }
+    ASSERT(count > 0);
+    target = async::Place::epoch.fetch_add(1) + 1;
+    MLOG_DETAIL(mlog::cap, "start delete broadcast", DVAR(target), DVAR(count));
+    startRound();
+  }
+
+  void DeleteBroadcast::finished()
+  {
+    // continue on a fresh stack instead of deep inside the tree traversal
+    getLocalPlace().run(finisher.set([](Tasklet*) { finishGracePeriod(); }));
   }
 
-  void DeleteBroadcast::broadcast(Tasklet* t, IResult<void>* res, DeleteBroadcast* start)
+  void DeleteBroadcast::finishGracePeriod()
   {
-    DeleteBroadcast* pnext = this->next;
-    while (pnext != start && !pnext->home->isActive()) pnext = pnext->next;
-    if (pnext != start) {
-      MLOG_DETAIL(mlog::cap, "relay delete broadcast");
-      pnext->home->run(t->set( [=](Tasklet* t){ pnext->broadcast(t, res, start); } ));
-    } else {
-      MLOG_DETAIL(mlog::cap, "end delete broadcast");
-      res->response(t);
+    MLOG_DETAIL(mlog::cap, "end delete broadcast", DVAR(target));
+    auto& place = getLocalPlace();
+    auto t = batch;
+    batch = nullptr;
+    while (t != nullptr) {
+      auto next = reinterpret_cast<async::TaskletBase*>(t->next.load(std::memory_order_relaxed));
+      t->setInit();
+      place.run(t);
+      t = next;
     }
+    // start the next grace period if requests arrived in the meantime
+    if (!waiting.tryRelease()) startGracePeriod();
   }
 
 } // namespace mythos
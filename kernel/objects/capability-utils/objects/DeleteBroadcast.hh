@@ -27,23 +27,46 @@
 
 #include "async/Place.hh"
 #include "async/IResult.hh"
+#include "async/TaskletQueue.hh"
+#include "objects/BroadcastTree.hh"
 
 namespace mythos {
 
+/** Waits for a grace period, after which no place holds a reference
+ * to an object that was unlinked before.
+ *
+ * The deletions are batched: all requests that arrive while a grace
+ * period is in progress are covered together by the next one. A grace
+ * period advances the global epoch and then visits the places along
+ * the BroadcastTree. Places that are not in the kernel or that left
+ * the kernel after the epoch advanced are quiescent and skipped.
+ */
 class DeleteBroadcast
+  : public BroadcastTree<DeleteBroadcast>
 {
 public:
-  DeleteBroadcast() : next(nullptr), home(nullptr) {}
   static void init();
   static void run(Tasklet* t, IResult<void>* res);
 
 private:
-  void broadcast(Tasklet* t, IResult<void>* res, DeleteBroadcast* start);
+  friend class BroadcastTree<DeleteBroadcast>;
+  bool mustVisit() const {
+    return home->isActive() && home->getQuiescentEpoch() < target;
+  }
+  /** nothing to do, the visit itself is the evidence: it runs after
+   * all tasks that were queued on the place before the grace period. */
+  void visitLocal() {}
+  static void finished();
+
+  static void startGracePeriod();
+  static void finishGracePeriod();
 
 private:
-  DeleteBroadcast* next;
-  async::Place* home;
   static DeleteBroadcast nodes[];
+  static async::TaskletQueue waiting; //< requests for the next grace period
+  static async::TaskletBase* batch; //< requests covered by the current grace period, linked through their next field
+  static uint64_t target; //< the epoch of the current grace period
+  static Tasklet finisher;
 };
 
 } // namespace mythos
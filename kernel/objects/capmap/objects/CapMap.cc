@@ -103,28 +103,51 @@ namespace mythos {
 
   optional<CapEntryRef> CapMap::lookup(Cap self, CapPtr ptr, CapPtrDepth depth, bool writable)
   {
-    if (writable && !CapMapData(self.data()).writable) { THROW(Error::NO_LOOKUP); }
-    CapPtr guard = this->guard;
-    CapPtrDepth guardbits = this->guardbits;
-    if (depth < guardbits+indexbits)
-      THROW(Error::INVALID_CAPABILITY); // ptr is too small
-    if (ptr >> (ptrbits-guardbits) != guard)
-      THROW(Error::INVALID_CAPABILITY); // guard not matching
-    depth = CapPtrDepth(depth - guardbits);
-    ptr <<= guardbits; // strip guard from address
-    CapPtr index = ptr >> (ptrbits-indexbits); // get index
-    depth = CapPtrDepth(depth - indexbits);
-    ptr <<= indexbits; // strip index from address
-    CapEntry* entry = caps()+index;
-    if (depth == 0) return CapEntryRef(entry, this); // reached end of address => return entry
-    TypedCap<ICapMap> sub(entry->cap());
-    if (!sub) RETHROW(sub.state());
-    return sub.lookup(ptr, depth, writable); // recursive lookup
+    // Walks down the nested maps in a loop instead of recursing through
+    // ICapMap::lookup: a single-level address needs no virtual call at
+    // all, each nested map costs just one vcast.
+    CapMap* map = this;
+    while (true) {
+      if (writable && !CapMapData(self.data()).writable) { THROW(Error::NO_LOOKUP); }
+      CapPtrDepth guardbits = map->guardbits;
+      CapPtrDepth indexbits = map->indexbits;
+      if (depth < guardbits+indexbits)
+        THROW(Error::INVALID_CAPABILITY); // ptr is too small
+      uint64_t addr = ptr; // 64bit shifts stay defined for zero guard and index bits
+      if (addr >> (ptrbits-guardbits) != map->guard)
+        THROW(Error::INVALID_CAPABILITY); // guard not matching
+      addr = (addr << guardbits) & CapPtr(-1); // strip guard from address
+      CapPtr index = CapPtr(addr >> (ptrbits-indexbits)); // get index
+      addr = (addr << indexbits) & CapPtr(-1); // strip index from address
+      depth = CapPtrDepth(depth - guardbits - indexbits);
+      ptr = CapPtr(addr);
+      CapEntry* entry = map->caps()+index;
+      if (depth == 0) return CapEntryRef(entry, map); // reached end of address => return entry
+      TypedCap<CapMap> sub(entry->cap());
+      if (!sub) RETHROW(sub.state());
+      self = sub.cap();
+      map = sub.obj();
+    }
   }
 
   void CapMap::invoke(Tasklet* t, Cap self, IInvocation* msg)
   {
-    /// @todo Monitor might not be neccessary for derive, reference
+    if (msg->getProtocol() == protocol::CapMap::proto) {
+      switch (protocol::CapMap::Methods(msg->getMethod())) {
+      case protocol::CapMap::DERIVE:
+      case protocol::CapMap::REFERENCE: {
+        // The lookups read the entries without locks and inserting the new
+        // capability locks just the involved entries. Thus, these run directly
+        // on the invoking place. The reference delays the map's deletion.
+        monitor.acquireRef();
+        auto err = protocol::CapMap::dispatchRequest(this, msg->getMethod(), t, self, msg);
+        msg->replyResponse(err);
+        monitor.releaseRef();
+        return;
+      }
+      default: break;
+      }
+    }
     monitor.request(t, [=](Tasklet* t){
         Error err = Error::NOT_IMPLEMENTED;
         switch (msg->getProtocol()) {
@@ -213,6 +236,7 @@ namespace mythos {
   optional<void const*> CapMap::vcast(TypeId id) const
   {
     if (id == typeId<ICapMap>()) { return static_cast<const ICapMap*>(this); }
+    if (id == typeId<CapMap>()) { return this; }
     THROW(Error::TYPE_MISMATCH);
   }
 }  // namespace mythos
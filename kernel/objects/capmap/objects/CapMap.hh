@@ -31,7 +31,7 @@
 #include "util/align.hh"
 #include "mythos/protocol/CapMap.hh"
 #include "mythos/protocol/KernelObject.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/CapEntry.hh"
 #include "objects/IKernelObject.hh"
 #include "objects/IAllocator.hh"
@@ -95,7 +95,7 @@ private:
 
   LinkedList<IKernelObject*>::Queueable del_handle = {this};
   IAsyncFree* memory;
-  async::NestedMonitorDelegating monitor;
+  async::ObjectMonitor monitor;
 };
 
 class CapMapFactory : public FactoryBase
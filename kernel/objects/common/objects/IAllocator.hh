@@ -29,6 +29,7 @@
 #include <new>
 #include "async/IResult.hh"
 #include "util/error-trace.hh"
+#include "util/mstring.hh"
 
 namespace mythos {
 
@@ -71,6 +72,14 @@ namespace mythos {
     virtual optional<void*> alloc(size_t length, size_t alignment) = 0;
     virtual optional<void> alloc(MemoryDescriptor* begin, MemoryDescriptor* end) = 0;
 
+    /** allocates memory that is filled with zeros. Allocators may
+     * hand out pre-zeroed memory instead of clearing it here. */
+    virtual optional<void*> allocZeroed(size_t length, size_t alignment) {
+      auto ptr = alloc(length, alignment);
+      if (ptr) memset(*ptr, 0, length);
+      return ptr;
+    }
+
     template<class T, size_t ALIGN=64, class... ARGS>
     optional<T*> create(ARGS const&... args) {
       auto ptr = alloc(sizeof(T), ALIGN);
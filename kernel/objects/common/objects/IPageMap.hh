@@ -29,6 +29,7 @@
 #include <cstddef>
 #include "util/PhysPtr.hh"
 #include "util/optional.hh"
+#include "async/IResult.hh"
 #include "objects/Cap.hh"
 #include "mythos/protocol/PageMap.hh"
 #include "objects/TypedCap.hh"
@@ -60,10 +61,39 @@ namespace mythos {
     virtual optional<void> mapTable(uintptr_t vaddr, size_t level, CapEntry* tableEntry, MapFlags flags,
                                     uintptr_t* failaddr, size_t* faillevel) = 0;
     
+    /** arguments and fail position of an asynchronous mapFrame. */
+    struct MapFrameRequest {
+      uintptr_t vaddr;
+      size_t size;
+      CapEntry* frameEntry;
+      MapFlags flags;
+      uintptr_t offset;
+      uintptr_t failaddr;
+      size_t faillevel;
+    };
+
+    /** mapFrame inside the page map's monitor for other kernel objects.
+     * The request has to stay valid until the response. */
+    virtual void mapFrame(Tasklet* t, IResult<void>* r, MapFrameRequest* req) = 0;
+
     virtual optional<void> mapFrame(size_t index, CapEntry* frameEntry, MapFlags flags, size_t offset) = 0;
     virtual optional<void> unmapEntry(size_t index) = 0;
 
     virtual optional<void> mapTable(CapEntry* table, MapFlags req, size_t index) = 0;
+
+    /** tries to resolve a write fault on a present page at vaddr inside
+     * the kernel by copying a copy-on-write page. Returns false if the
+     * mapping is neither copy-on-write nor writable by now, then the
+     * fault has to be handled by the user. Otherwise the page is copied
+     * in the monitor of the page map that owns the entry and the
+     * response follows. */
+    virtual bool resolveFault(Tasklet* t, IResult<void>* r, uintptr_t vaddr) = 0;
+
+    /** invalidates the translation of vaddr on the other hardware
+     * threads that have this root map loaded, e.g. after resolveFault
+     * replaced a read-only page. Returns false if there are none,
+     * otherwise the response follows after the invalidation. */
+    virtual bool shootdown(Tasklet* t, IResult<void>* r, uintptr_t vaddr) = 0;
   };
 
 } // namespace mythos
@@ -30,6 +30,8 @@
 
 namespace mythos {
 
+  namespace async { class Place; }
+
   class IThread;
   class ISchedulable;
   class Tasklet;
@@ -55,6 +57,11 @@ namespace mythos {
      */
     virtual void ready(handle_t* ec_handle) = 0;
 
+    /** The hardware thread that runs the bound execution contexts. This
+     * is the only place where their state can be loaded.
+     */
+    virtual async::Place* getHome() const = 0;
+
   };
 
 } // namespace mythos
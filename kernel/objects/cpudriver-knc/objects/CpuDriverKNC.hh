@@ -25,7 +25,7 @@
  */
 #pragma once
 
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/IKernelObject.hh"
 
 namespace mythos {
@@ -44,7 +44,7 @@ public:
 
 protected:
   /// @todo or one instance per hardware thread with HomeMonitor?
-  async::NestedMonitorDelegating monitor;
+  async::ObjectMonitor monitor;
 };
 
 } // namespace mythos
@@ -27,7 +27,7 @@
 
 #include <array>
 #include <cstddef>
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/IFactory.hh"
 #include "objects/IKernelObject.hh"
 #include "objects/CapEntry.hh"
@@ -61,7 +61,7 @@ protected:
   Error printMessage(Tasklet* t, Cap self, IInvocation* msg);
 
 protected:
-  async::NestedMonitorDelegating monitor;
+  async::ObjectMonitor monitor;
   IDeleter::handle_t del_handle = {this};
   IAsyncFree* _mem;
   friend class ExampleFactory;
@@ -33,8 +33,10 @@
 #include "objects/ops.hh"
 #include "objects/DebugMessage.hh"
 #include "objects/IPageMap.hh"
+#include "objects/CapMap.hh"
 #include "util/error-trace.hh"
 #include "mythos/syscall.hh"
+#include "mythos/LogRing.hh"
 
 namespace mythos {
 
@@ -47,6 +49,7 @@ namespace mythos {
     threadState.clear();
     threadState.rflags = x86::FLAG_IF; // ensure that interrupts are enabled in user mode
     fpuState.clear();
+    pmcState.clear();
   }
 
   void ExecutionContext::setFlagsSuspend(flag_t f)
@@ -112,25 +115,25 @@ namespace mythos {
     TypedCap<IScheduler> obj(sce);
     if (!obj) RETHROW(obj);
 
-    // check if the EC state is currently loaded somewhere
-    auto place = currentPlace.exchange(nullptr);
-    if (place != nullptr) {
-        // save my state
-        place->run(t->set([this, msg, sce](Tasklet*){
-            this->fpuState.save();
-            TypedCap<IScheduler> obj(sce);
-            if (!obj) {
-              msg->replyResponse(obj.state());
-              monitor.requestDone();
-            }
-            auto res = _sched.set(this, *sce, obj.cap());
-            msg->replyResponse(res);
-            monitor.requestDone();
-            }));
-        RETURN(Error::INHIBIT);
-    } else {
-        RETURN(_sched.set(this, *sce, obj.cap()));
-    }
+    // The state can be loaded only on the home of the old scheduler, or
+    // wherever it was left when the EC had no scheduler at all. The move
+    // happens there: the state is saved, which includes the FPU and
+    // counters, and the old scheduler forgets the EC while unbinding. The
+    // new scheduler's hardware thread then loads the state lazily.
+    auto old = _sched.get();
+    auto place = old ? old->getHome() : currentPlace.load();
+    if (place == nullptr) RETURN(_sched.set(this, *sce, obj.cap()));
+
+    MLOG_DETAIL(mlog::ec, "migrate", DVAR(this), DVAR(place));
+    place->run(t->set([this, msg, sce](Tasklet*){
+        if (currentPlace.load() == &getLocalPlace()) this->saveState();
+        TypedCap<IScheduler> obj(sce);
+        optional<void> res(obj.state());
+        if (obj) res = _sched.set(this, *sce, obj.cap());
+        msg->replyResponse(res);
+        monitor.requestDone();
+      }));
+    RETURN(Error::INHIBIT);
   }
 
   Error ExecutionContext::unsetSchedulingContext()
@@ -156,12 +159,33 @@ namespace mythos {
   optional<void> ExecutionContext::setCapSpace(optional<CapEntry*> cse)
   {
     MLOG_INFO(mlog::ec, "setCapSpace", DVAR(this), DVAR(cse));
-    TypedCap<ICapMap> obj(cse);
+    TypedCap<CapMap> obj(cse);
     if (!obj) RETHROW(obj);
     RETURN(_cs.set(this, *cse, obj.cap()));
 
   }
 
+  optional<void> ExecutionContext::setPager(optional<CapEntry*> sinkref, KEvent::Context context)
+  {
+    MLOG_INFO(mlog::ec, "setPager", DVAR(this), DVAR(sinkref), DVARhex(context));
+    TypedCap<IKEventSink> obj(sinkref);
+    if (!obj) RETHROW(obj);
+    _faultMutex << [this, context] { _pagerContext = context; };
+    RETURN(_pager.set(this, *sinkref, obj.cap()));
+  }
+
+  void ExecutionContext::unbind(optional<IKEventSink*> pager)
+  {
+    // called after the capability was killed, thus no new fault event can be attached
+    ASSERT(pager);
+    _faultMutex << [this, pager] {
+      if (_faultAttached) {
+        pager->detachKEvent(&_faultEvent);
+        _faultAttached = false;
+      }
+    };
+  }
+
   void ExecutionContext::setEntryPoint(uintptr_t rip)
   {
     MLOG_INFO(mlog::ec, "EC setEntryPoint", DVARhex(rip));
@@ -170,9 +194,9 @@ namespace mythos {
 
   optional<CapEntryRef> ExecutionContext::lookupRef(CapPtr ptr, CapPtrDepth ptrDepth, bool writable)
   {
-    TypedCap<ICapMap> cs(_cs.cap());
-    if (!cs) RETHROW(cs);
-    RETURN(cs.lookup(ptr, ptrDepth, writable));
+    auto cs = _csMap.load();
+    if (!cs) THROW(Error::INVALID_CAPABILITY);
+    RETURN(cs->lookup(_cs.cap(), ptr, ptrDepth, writable));
   }
 
   Error ExecutionContext::invokeConfigure(Tasklet* t, Cap, IInvocation* msg)
@@ -362,6 +386,92 @@ namespace mythos {
     return res.state();
   }
 
+  Error ExecutionContext::invokeConfigureCounters(Tasklet* t, Cap, IInvocation* msg)
+  {
+    static_assert(protocol::ExecutionContext::ConfigureCounters::NUM_PMCS == cpu::PmcState::NUM_PMCS,
+                  "counter numbers of protocol and kernel differ");
+    static_assert(protocol::ExecutionContext::Counters::NUM_FIXED == cpu::PmcState::NUM_FIXED,
+                  "counter numbers of protocol and kernel differ");
+    auto home = currentPlace.load();
+    if (home == nullptr) {
+      auto data = msg->getMessage()->read<protocol::ExecutionContext::ConfigureCounters>();
+      return pmcState.configure(data.eventSelect, data.fixed, data.userRead).state();
+    }
+
+    // reprogram the hardware where the counters are loaded
+    home->run(t->set([this, msg](Tasklet*){
+        auto data = msg->getMessage()->read<protocol::ExecutionContext::ConfigureCounters>();
+        bool loaded = currentPlace.load() == &getLocalPlace();
+        if (loaded) pmcState.save();
+        auto res = pmcState.configure(data.eventSelect, data.fixed, data.userRead);
+        if (loaded) pmcState.restore();
+        msg->replyResponse(res);
+        monitor.requestDone();
+      }));
+    return Error::INHIBIT;
+  }
+
+  Error ExecutionContext::invokeReadCounters(Tasklet* t, Cap, IInvocation* msg)
+  {
+    auto home = currentPlace.load();
+    if (home == nullptr) return readCounters(msg);
+
+    // collect the progress of the loaded counters first
+    home->run(t->set([this, msg](Tasklet*){
+        if (currentPlace.load() == &getLocalPlace()) pmcState.update();
+        msg->replyResponse(readCounters(msg));
+        monitor.requestDone();
+      }));
+    return Error::INHIBIT;
+  }
+
+  Error ExecutionContext::readCounters(IInvocation* msg)
+  {
+    auto data = msg->getMessage()->write<protocol::ExecutionContext::Counters>();
+    for (size_t i = 0; i < data->NUM_PMCS; i++) data->pmc[i] = pmcState.pmc[i];
+    for (size_t i = 0; i < data->NUM_FIXED; i++) data->fixed[i] = pmcState.fixed[i];
+    return Error::SUCCESS;
+  }
+
+  Error ExecutionContext::invokeSetPager(Tasklet*, Cap, IInvocation* msg)
+  {
+    auto data = msg->getMessage()->read<protocol::ExecutionContext::SetPager>();
+    if (data.pager() == delete_cap) unsetPager();
+    else if (data.pager() != null_cap) return setPager(msg->lookupEntry(data.pager()), data.context).state();
+    return Error::SUCCESS;
+  }
+
+  Error ExecutionContext::invokeResolveFault(Tasklet* t, Cap, IInvocation* msg)
+  {
+    auto data = msg->getMessage()->read<protocol::ExecutionContext::ResolveFault>();
+    if (data.pagemap() == null_cap) {
+      clearFlagsResume(IS_TRAPPED);
+      return Error::SUCCESS;
+    }
+    TypedCap<IPageMap> pm(msg->lookupEntry(data.pagemap()));
+    if (!pm) return pm.state();
+    if (!pm->getPageMapInfo(pm.cap()).configurable) return Error::REQUEST_DENIED;
+    auto frameEntry = msg->lookupEntry(data.frame());
+    if (!frameEntry) return frameEntry.state();
+    // map in the page map's monitor and resume in the response
+    this->msg = msg;
+    resolveRequest = {data.vaddr, data.size, *frameEntry, data.flags, data.offset, 0, 0};
+    pm->mapFrame(t, &resolveFaultResponse, &resolveRequest);
+    return Error::INHIBIT;
+  }
+
+  void ExecutionContext::resolveFaultMapped(Tasklet* t, optional<void> res)
+  {
+    ASSERT(msg);
+    monitor.response(t,[=](Tasklet*){
+        msg->getMessage()->write<protocol::PageMap::Result>(resolveRequest.failaddr, resolveRequest.faillevel);
+        if (res) clearFlagsResume(IS_TRAPPED);
+        msg->replyResponse(res.state());
+        msg = nullptr;
+        monitor.responseAndRequestDone();
+      });
+  }
+
   void ExecutionContext::attachKEvent(IKEventSink::handle_t* event)
   {
     MLOG_INFO(mlog::ec, "got KEvent", DVAR(this), DVAR(event));
@@ -374,8 +484,84 @@ namespace mythos {
     eventQueue.remove(event);
   }
 
+  bool ExecutionContext::resolvePageFault()
+  {
+    auto ctx = &threadState;
+    typedef protocol::ExecutionContext::PageFault PageFault;
+    if (ctx->irq != 14 || !PageFault::forwardable(ctx->cr2)) return false;
+    PageFault fault(PageFault::encode(ctx->cr2, ctx->error));
+    // only a plain write to a present page can hit a copy-on-write mapping
+    if (!fault.protectedWrite()) return false;
+    TypedCap<IPageMap> as(_as);
+    if (!as) return false;
+    // like an interrupt, the faulting instruction is repeated, but only after the page
+    // was copied and the other hardware threads dropped the replaced read-only translation
+    setFlags(NOT_RUNNING | IN_PAGE_FAULT);
+    if (as->resolveFault(&pageFaultTask, &pageFaultResponse, fault.addr)) return true;
+    clearFlags(IN_PAGE_FAULT);
+    return false;
+  }
+
+  void ExecutionContext::pageFaultResolved(Tasklet* t, optional<void> res)
+  {
+    auto ctx = &threadState;
+    MLOG_DETAIL(mlog::ec, "resolve page fault", DVAR(this), DVARhex(ctx->cr2), DVARhex(ctx->error), DVAR(res.state()));
+    if (!res) {
+      handleFault(); // blocks the execution context before it is resumed
+      clearFlagsResume(IN_PAGE_FAULT);
+      return;
+    }
+    TypedCap<IPageMap> as(_as);
+    if (!as || !as->shootdown(t, &shootdownResponse, ctx->cr2)) clearFlagsResume(IN_PAGE_FAULT);
+  }
+
+  void ExecutionContext::shootdownDone(Tasklet*, optional<void>)
+  {
+    clearFlagsResume(IN_PAGE_FAULT);
+  }
+
+  bool ExecutionContext::forwardPageFault()
+  {
+    auto ctx = &threadState;
+    typedef protocol::ExecutionContext::PageFault PageFault;
+    if (ctx->irq != 14 || !PageFault::forwardable(ctx->cr2)) return false;
+    bool forwarded = false;
+    _faultMutex << [this, ctx, &forwarded] {
+      TypedCap<IKEventSink> pager(_pager);
+      if (!pager) return;
+      _pageFault = PageFault::encode(ctx->cr2, ctx->error);
+      // suspend before the pager can see the event and resume us
+      setFlags(IS_TRAPPED | NOT_RUNNING);
+      if (!_faultAttached) {
+        pager->attachKEvent(&_faultEvent);
+        _faultAttached = true;
+      }
+      forwarded = true;
+    };
+    MLOG_DETAIL(mlog::ec, "page fault", DVAR(this), DVARhex(ctx->cr2), DVARhex(ctx->error), DVAR(forwarded));
+    return forwarded;
+  }
+
+  KEvent ExecutionContext::deliverKEvent()
+  {
+    KEvent result;
+    _faultMutex << [this, &result] {
+      result.user = _pagerContext;
+      result.state = _pageFault;
+      // the pager has pulled the handle from its queue already
+      _faultAttached = false;
+    };
+    return result;
+  }
+
   void ExecutionContext::handleTrap()
   {
+    if (!resolvePageFault()) handleFault();
+  }
+
+  void ExecutionContext::handleFault()
+  {
+    if (forwardPageFault()) return;
     auto ctx = &threadState;
     MLOG_INFO(mlog::ec, "user fault", DVAR(ctx->irq), DVAR(ctx->error),
          DVARhex(ctx->cr2));
@@ -460,16 +646,30 @@ namespace mythos {
         // userctx => address in users virtual memory. Yes, we fully trust the user :(
         // portal => string length
         char str[300];
-        memcpy(&str[0], reinterpret_cast<char*>(userctx), portal<300?portal:300);
-        mlog::sink->write((char const*)&str[0], portal);
+        for (size_t pos = 0; pos < portal; pos += sizeof(str)) {
+          auto len = portal - pos < sizeof(str) ? portal - pos : sizeof(str);
+          memcpy(&str[0], reinterpret_cast<char*>(userctx + pos), len);
+          mlog::sink->write((char const*)&str[0], len);
+        }
+        code = uint64_t(Error::SUCCESS);
+        break;
+      }
+
+      case SYSCALL_DEBUG_RING: {
+        MLOG_DETAIL(mlog::syscall, "debug ring", (void*)userctx);
+        // userctx => address of the process' LogRing in users virtual memory
+        if (userctx == 0 || userctx % alignof(LogRing) != 0) {
+          code = uint64_t(Error::INVALID_ARGUMENT);
+          break;
+        }
+        reinterpret_cast<LogRing*>(userctx)->drain(
+          [](char const* str, size_t len) { mlog::sink->write(str, len); });
         code = uint64_t(Error::SUCCESS);
         break;
       }
 
       case SYSCALL_SIGNAL: {
-        TypedCap<ICapMap> cs(_cs); // .cap()
-        if (!cs) { code = uint64_t(cs.state()); break; }
-        TypedCap<ISignalable> th(cs.lookup(CapPtr(portal), 32, false));
+        TypedCap<ISignalable> th(lookupRef(CapPtr(portal), 32, false));
         if (!th) { code = uint64_t(th.state()); break; }
         MLOG_DETAIL(mlog::syscall, "semaphore signal syscall", DVAR(portal), DVAR(th.obj()));
         th->signal(th.cap().data());
@@ -510,9 +710,7 @@ namespace mythos {
 
   optional<void> ExecutionContext::syscallInvoke(CapPtr portal, CapPtr dest, uint64_t user)
   {
-    TypedCap<ICapMap> cs(_cs.cap());
-    if (!cs) RETHROW(cs);
-    TypedCap<IPortal> p(cs.lookup(portal, 32, false));
+    TypedCap<IPortal> p(lookupRef(portal, 32, false));
     if (!p) RETHROW(p);
     RETURN(p.sendInvocation(dest, user));
   }
@@ -591,6 +789,7 @@ namespace mythos {
         ASSERT(cpu::thread_state.get() == nullptr);
         cpu::thread_state = &threadState;
         fpuState.restore();
+        pmcState.restore();
         // tell the kernel that this execution context is in charge now
         // and check that no other was loaded.
         ASSERT(current_ec->load() == nullptr);
@@ -611,6 +810,7 @@ namespace mythos {
         ASSERT(cpu::thread_state.get() == &threadState);
         cpu::thread_state = nullptr;
         fpuState.save();
+        pmcState.save();
 
         // tell the kernel that nobody is in charge now
         ASSERT(current_ec->load() == this);
@@ -632,6 +832,7 @@ namespace mythos {
             _as.reset();
             _cs.reset();
             _sched.reset();
+            _pager.reset();
             del.deleteObject(del_handle);
         }
         RETURN(Error::SUCCESS);
@@ -30,7 +30,8 @@
 
 #include "cpu/kernel_entry.hh"
 #include "cpu/fpu.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "cpu/PmcState.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/IKernelObject.hh"
 #include "objects/ISchedulable.hh"
 #include "objects/IScheduler.hh"
@@ -43,15 +44,19 @@
 #include "objects/CapRef.hh"
 #include "mythos/protocol/KernelObject.hh"
 #include "mythos/protocol/ExecutionContext.hh"
+#include "util/ThreadMutex.hh"
 
 namespace mythos {
 
+  class CapMap;
+
   class ExecutionContext final
     : public IKernelObject
     , public ISchedulable
     , public IPortalUser // includes IKEventSink
     , public ISignalable
     , public ISignalSource
+    , public IKEventSource // forwarded page faults
   {
   public:
 
@@ -62,13 +67,14 @@ namespace mythos {
       IS_TRAPPED = 1<<1, // used by suspend/resume invocations and trap/exception handler
       NO_AS      = 1<<2, // set if address space is missing
       NO_SCHED   = 1<<3, // set if scheduler is missing
+      IN_PAGE_FAULT = 1<<4, // waits for the kernel to copy a copy-on-write page and shoot down the old one
       IN_WAIT    = 1<<5, // EC is in wait() syscall, next sysret should return a KEvent
       IS_NOTIFIED     = 1<<6, // used by notify() syscall for binary semaphore
       REGISTER_ACCESS = 1<<7, // accessing registers
       NOT_LOADED   = 1<<8, // CPU state is not loaded
       DONT_PREEMPT  = 1<<9, // somebody else will send the preemption
       NOT_RUNNING  = 1<<10, // EC is not running
-      BLOCK_MASK = IS_WAITING | IS_TRAPPED | NO_AS | NO_SCHED | REGISTER_ACCESS
+      BLOCK_MASK = IS_WAITING | IS_TRAPPED | NO_AS | NO_SCHED | IN_PAGE_FAULT | REGISTER_ACCESS
     };
 
     ExecutionContext(IAsyncFree* memory);
@@ -79,12 +85,16 @@ namespace mythos {
 
     /// only for initial setup
     optional<void> setSchedulingContext(optional<CapEntry*> sce);
+    /// moves a possibly running execution context to another scheduler
     optional<void> setSchedulingContext(Tasklet* t, IInvocation* msg, optional<CapEntry*> sce);
     Error unsetSchedulingContext();
 
     optional<void> setCapSpace(optional<CapEntry*> capmapref);
     void unsetCapSpace() { _cs.reset(); }
 
+    optional<void> setPager(optional<CapEntry*> sinkref, KEvent::Context context);
+    void unsetPager() { _pager.reset(); }
+
     void setEntryPoint(uintptr_t rip);
     void setTrapped(bool val);
 
@@ -110,6 +120,9 @@ namespace mythos {
   public: // ISignalable interface
     optional<void> signal(CapData data) override;
 
+  public: // IKEventSource interface
+    KEvent deliverKEvent() override;
+
   public: // ISignalSource interface
 
     void attachSignalSink(ISignalSource::handle_t*) override;
@@ -118,6 +131,11 @@ namespace mythos {
   protected:
 
     void changeSignal(Signal signal);
+    bool resolvePageFault();
+    void pageFaultResolved(Tasklet* t, optional<void> res);
+    void shootdownDone(Tasklet* t, optional<void>);
+    bool forwardPageFault();
+    void handleFault();
 
   public: // IPortalUser interface
     optional<CapEntryRef> lookupRef(CapPtr ptr, CapPtrDepth ptrDepth, bool writeable) override;
@@ -149,15 +167,23 @@ namespace mythos {
     void suspendThread(Tasklet* t, optional<void>);
     Error getDebugInfo(Cap self, IInvocation* msg);
     Error invokeSetFSGS(Tasklet* t, Cap self, IInvocation* msg);
+    Error invokeConfigureCounters(Tasklet* t, Cap self, IInvocation* msg);
+    Error invokeReadCounters(Tasklet* t, Cap self, IInvocation* msg);
+    Error readCounters(IInvocation* msg);
+    Error invokeSetPager(Tasklet* t, Cap self, IInvocation* msg);
+    Error invokeResolveFault(Tasklet* t, Cap self, IInvocation* msg);
+    void resolveFaultMapped(Tasklet* t, optional<void> res);
 
   protected:
     friend class CapRefBind;
     void bind(optional<IPageMap*>);
-    void bind(optional<ICapMap*>) {}
+    void bind(optional<CapMap*> cs) { if (cs) _csMap.store(*cs); }
     void bind(optional<IScheduler*>);
+    void bind(optional<IKEventSink*>) {}
     void unbind(optional<IPageMap*>);
-    void unbind(optional<ICapMap*>) {}
+    void unbind(optional<CapMap*>) { _csMap.store(nullptr); }
     void unbind(optional<IScheduler*>);
+    void unbind(optional<IKEventSink*>);
 
     flag_t setFlags(flag_t f) { return flags.fetch_or(f); }
     flag_t clearFlags(flag_t f) { return flags.fetch_and(flag_t(~f)); }
@@ -167,14 +193,24 @@ namespace mythos {
     bool needPreemption(flag_t f) const { return (f & DONT_PREEMPT) == 0; }
 
   private:
-    async::NestedMonitorDelegating monitor;
+    async::ObjectMonitor monitor;
     IKEventSink::list_t eventQueue;
     std::atomic<flag_t> flags;
     CapRef<ExecutionContext,IPageMap> _as;
-    CapRef<ExecutionContext,ICapMap> _cs;
+    CapRef<ExecutionContext,CapMap> _cs;
+    std::atomic<CapMap*> _csMap = {nullptr}; //< cached object of _cs, saves the vcast per lookup
     CapRef<ExecutionContext,IScheduler> _sched;
     ISignalSource::list_t _sinkList;
 
+    CapRef<ExecutionContext,IKEventSink> _pager;
+    /** protects the fault event against concurrent unbind of the pager,
+     * like the mutex in SignalListener. */
+    ThreadMutex _faultMutex;
+    bool _faultAttached = false;
+    KEvent::Context _pagerContext = 0;
+    KEvent::Value _pageFault = 0;
+    IKEventSink::handle_t _faultEvent = {this};
+
     // the hardware thread where the fpu state is currently loaded
     std::atomic<async::Place*> currentPlace = {nullptr};
     IScheduler::handle_t ec_handle = {this};
@@ -186,9 +222,18 @@ namespace mythos {
       writeSleepResponse = {this};
     async::MSink<ExecutionContext, void, &ExecutionContext::suspendThread>
       sleepResponse = {this};
+    async::MSink<ExecutionContext, void, &ExecutionContext::resolveFaultMapped>
+      resolveFaultResponse = {this};
+    IPageMap::MapFrameRequest resolveRequest;
+    async::MSink<ExecutionContext, void, &ExecutionContext::pageFaultResolved>
+      pageFaultResponse = {this};
+    async::MSink<ExecutionContext, void, &ExecutionContext::shootdownDone>
+      shootdownResponse = {this};
+    Tasklet pageFaultTask; //< for the copy and then the shootdown
 
     cpu::ThreadState threadState;
     cpu::FpuState fpuState;
+    cpu::PmcState pmcState;
 
     LinkedList<IKernelObject*>::Queueable del_handle = {this};
     IAsyncFree* memory;
@@ -27,6 +27,7 @@
 #include "objects/InterruptControl.hh"
 #include "mythos/protocol/InterruptControl.hh"
 #include "objects/mlog.hh"
+#include "cpu/IOApic.hh"
 
 namespace mythos {
 
@@ -82,8 +83,15 @@ Error InterruptControl::registerForInterrupt(Tasklet *t, Cap self, IInvocation *
     optional<CapEntry*> capEntry = msg->lookupEntry(data.ec());
     TypedCap<ISignalable> obj(capEntry);
     if (!obj) return Error::INVALID_CAPABILITY;
+    pending[data.interrupt].store(0);
     destinations[data.interrupt].set(this, *capEntry, obj.cap());
     MLOG_DETAIL(mlog::irq, "registerForInterrupt", DVAR(t), DVAR(self), DVAR(data.ec()), DVAR(data.interrupt));
+    // steer the interrupt to this controller's hardware thread
+    auto ioapic = findIOApic(data.interrupt);
+    if (ioapic && home) {
+        ioapic->routeIRQ(data.interrupt, home->getApicID());
+        ioapic->unmaskIRQ(data.interrupt);
+    }
     return Error::SUCCESS;
 }
 
@@ -91,8 +99,10 @@ Error InterruptControl::unregisterInterrupt(Tasklet*/* t*/, Cap self, IInvocatio
     auto data = msg->getMessage()->read<protocol::InterruptControl::Unregister>();
     if (!isValid(data.interrupt)) return Error::INVALID_ARGUMENT;
     MLOG_DETAIL(mlog::irq, "unregisterInterrupt", DVAR(self), DVAR(data.interrupt));
+    maskIRQ(data.interrupt);
     destinations[data.interrupt].reset();
     ASSERT(!destinations[data.interrupt].isUsable());
+    pending[data.interrupt].store(0);
     return Error::SUCCESS;
 }
 
@@ -106,13 +116,24 @@ Error InterruptControl::maskIRQ(Tasklet* /*t*/, Cap /*self*/, IInvocation *msg)
 Error InterruptControl::unmaskIRQ(Tasklet* /*t*/, Cap /*self*/, IInvocation *msg) {
     auto data = msg->getMessage()->read<protocol::InterruptControl::MaskIRQ>();
     if (!isValid(data.interrupt)) return Error::INVALID_ARGUMENT;
+    pending[data.interrupt].store(0); // re-arm the signal
+    unmaskIRQ(data.interrupt);
+    return Error::SUCCESS;
+}
+
+Error InterruptControl::acknowledge(Tasklet* /*t*/, Cap /*self*/, IInvocation *msg) {
+    auto data = msg->getMessage()->read<protocol::InterruptControl::Acknowledge>();
+    if (!isValid(data.interrupt)) return Error::INVALID_ARGUMENT;
+    auto count = pending[data.interrupt].exchange(0);
     unmaskIRQ(data.interrupt);
+    msg->getMessage()->write<protocol::InterruptControl::Pending>()->count = count;
     return Error::SUCCESS;
 }
 
 void InterruptControl::handleInterrupt(uint64_t interrupt) {
     ASSERT(isValid(interrupt));
-    if (destinations[interrupt].isUsable()) {
+    // signal once per batch, the following interrupts are just counted
+    if (destinations[interrupt].isUsable() && pending[interrupt].fetch_add(1) == 0) {
         MLOG_DETAIL(mlog::irq, "Forward interrupt ", DVAR(interrupt));
         maskIRQ(interrupt);
         mythos::lapic.endOfInterrupt();
@@ -125,14 +146,16 @@ void InterruptControl::handleInterrupt(uint64_t interrupt) {
 
 void InterruptControl::maskIRQ(uint64_t interrupt) {
     ASSERT(isValid(interrupt));
-    MLOG_WARN(mlog::irq, "No IOApic present, can not mask", DVAR(interrupt));
-    //ioapic.maskIRQ(interrupt);
+    auto ioapic = findIOApic(interrupt);
+    if (ioapic) ioapic->maskIRQ(interrupt);
+    else MLOG_DETAIL(mlog::irq, "No IOApic for interrupt, can not mask", DVAR(interrupt));
 }
 
 void InterruptControl::unmaskIRQ(uint64_t interrupt) {
     ASSERT(isValid(interrupt));
-    MLOG_WARN(mlog::irq, "No IOApic present, can not unmask", DVAR(interrupt));
-    //ioapic.unmaskIRQ(interrupt);
+    auto ioapic = findIOApic(interrupt);
+    if (ioapic) ioapic->unmaskIRQ(interrupt);
+    else MLOG_DETAIL(mlog::irq, "No IOApic for interrupt, can not unmask", DVAR(interrupt));
 }
 
 } // namespace mythos
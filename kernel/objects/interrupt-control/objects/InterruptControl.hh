@@ -29,6 +29,9 @@
 #include "objects/CapRef.hh"
 #include "objects/ISignalable.hh"
 #include "mythos/protocol/KernelObject.hh"
+#include "async/ObjectMonitor.hh"
+#include "async/Place.hh"
+#include <atomic>
 
 namespace mythos {
 
@@ -39,6 +42,8 @@ class InterruptControl
 public:
     InterruptControl()
         {}
+    /** the controller handles the interrupts that arrive at this place */
+    void init(async::Place* home) { this->home = home; }
 public: // IKernelObject interface
     optional<void const*> vcast(TypeId id) const override;
     optional<void> deleteCap(CapEntry&, Cap self, IDeleter& del) override;
@@ -56,6 +61,7 @@ public: // protocol
     Error unregisterInterrupt(Tasklet *t, Cap self, IInvocation *msg);
     Error maskIRQ(Tasklet *t, Cap self, IInvocation *msg);
     Error unmaskIRQ(Tasklet *t, Cap self, IInvocation *msg);
+    Error acknowledge(Tasklet *t, Cap self, IInvocation *msg);
 public:
     void handleInterrupt(uint64_t interrupt);
     void maskIRQ(uint64_t interrupt);
@@ -65,10 +71,13 @@ private:
 private:
     /** list handle for the deletion procedure */
     LinkedList<IKernelObject*>::Queueable del_handle = {this};
-    async::NestedMonitorDelegating monitor;
+    async::ObjectMonitor monitor;
+    async::Place* home = nullptr;
 
     // actual interrupt handling members
     CapRef<InterruptControl, ISignalable> destinations[256];
+    /** interrupts since the last acknowledge, only the first one is signalled */
+    std::atomic<uint32_t> pending[256];
 };
 
 } // namespace mythos
@@ -30,6 +30,7 @@
 #include <new>
 #include "util/assert.hh"
 #include "util/align.hh"
+#include "util/mstring.hh"
 
 namespace mythos {
 
@@ -47,7 +48,8 @@ KernelMemory::KernelMemory(IAsyncFree* parent, Range<uintptr_t> range)
 
 optional<void*> KernelMemory::alloc(size_t length, size_t alignment)
 {
-  auto result = heap.alloc(length, alignment);
+  optional<uintptr_t> result;
+  heapMutex << [&]{ result = heapAlloc(length, alignment); };
   if (result) {
     MLOG_INFO(mlog::km, "alloc", DVAR(length), DVARhex(alignment), DVARhex(*result));
     monitor.acquireRef();
@@ -65,7 +67,7 @@ optional<void> KernelMemory::alloc(MemoryDescriptor* begin, MemoryDescriptor* en
   for (; it != end; ++it) {
     ASSERT(it->size > 0);
     ASSERT(!it->ptr);
-    result = heap.alloc(it->size, it->alignment);
+    heapMutex << [&]{ result = heapAlloc(it->size, it->alignment); };
     if (result) {
       MLOG_INFO(mlog::km, "alloc", DVAR(it->size), DVARhex(it->alignment), DVARhex(*result));
       monitor.acquireRef();
@@ -90,7 +92,7 @@ void KernelMemory::free(void* ptr, size_t length)
   MLOG_INFO(mlog::km, "free", DVARhex(ptr), DVARhex(length));
   ASSERT(_range.contains(freeRange));
   monitor.releaseRef();
-  heap.free(start, length);
+  heapMutex << [&]{ heap.free(start, length); };
 }
 
 void KernelMemory::free(MemoryDescriptor* begin, MemoryDescriptor* end)
@@ -98,6 +100,81 @@ void KernelMemory::free(MemoryDescriptor* begin, MemoryDescriptor* end)
   for (auto it = begin; it != end; ++it) free(it->ptr, it->size);
 }
 
+optional<void*> KernelMemory::allocZeroed(size_t length, size_t alignment)
+{
+  void* block = nullptr;
+  if (pool.fits(length, alignment)) {
+    heapMutex << [&]{
+      block = pool.pull();
+      // return the unused rest of the block to the heap
+      auto used = round_up(length, heap.getAlignment());
+      if (block && used < pool.size) heap.free(reinterpret_cast<uintptr_t>(block) + used, pool.size - used);
+    };
+  }
+  if (block) {
+    MLOG_INFO(mlog::km, "alloc pre-zeroed", DVAR(length), DVARhex(alignment), DVARhex(block));
+    monitor.acquireRef();
+    return block;
+  }
+  // the pool holds only blocks of pool.size, larger requests like the caps
+  // arrays of page maps and cap maps are taken from the heap and zeroed here
+  auto result = alloc(length, alignment);
+  if (result) memset(*result, 0, length);
+  return result;
+}
+
+optional<uintptr_t> KernelMemory::heapAlloc(size_t length, size_t alignment)
+{
+  auto result = heap.alloc(length, alignment);
+  if (!result && drainPool()) result = heap.alloc(length, alignment);
+  return result;
+}
+
+bool KernelMemory::drainPool()
+{
+  bool drained = false;
+  for (auto block = pool.pull(); block; block = pool.pull()) {
+    heap.free(reinterpret_cast<uintptr_t>(block), pool.size);
+    drained = true;
+  }
+  if (drained) MLOG_INFO(mlog::km, "drained pre-zeroed pool");
+  return drained;
+}
+
+void KernelMemory::refillZeroed(async::Place& place)
+{
+  if (refilling.exchange(true)) return;
+  place.pushShared(refillTask.set([this](Tasklet* t){
+    monitor.request(t, [this](Tasklet* t){
+      // the block is taken only if the reserve behind it stays free,
+      // real allocations shall not compete with the pool for the last memory
+      optional<uintptr_t> block;
+      heapMutex << [&]{
+        block = heap.alloc(pool.size + REFILL_RESERVE, pool.size);
+        if (block) heap.free(*block + pool.size, REFILL_RESERVE);
+      };
+      if (!block) {
+        refilling.store(false);
+        monitor.requestDone();
+        return;
+      }
+      auto ptr = reinterpret_cast<void*>(*block);
+      auto home = t->getOrigin();
+      monitor.requestDone();
+      // zero outside of the monitor on the idle hardware thread
+      home->run(t->set([this,ptr](Tasklet* t){
+        memzero_nt(ptr, pool.size);
+        monitor.request(t, [this,ptr](Tasklet*){
+          MLOG_DETAIL(mlog::km, "refilled pre-zeroed block", DVARhex(ptr), DVARhex(pool.size));
+          heapMutex << [&]{ pool.push(ptr); };
+          refilling.store(false);
+          monitor.requestDone();
+        });
+      }));
+    });
+  }));
+}
+
 void KernelMemory::addRange(PhysPtr<void> start, size_t length)
 {
   if (!start.kernelmem()) return;
@@ -26,9 +26,12 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include "util/assert.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "util/align.hh"
+#include "async/ObjectMonitor.hh"
 #include "util/FirstFitHeap.hh"
+#include "util/ThreadMutex.hh"
 #include "objects/IAllocator.hh"
 #include "objects/IKernelObject.hh"
 #include "objects/CapEntry.hh"
@@ -57,10 +60,28 @@ namespace mythos {
     void addRange(PhysPtr<void> start, size_t length);
 
   public: // IAllocator interface: synchrounous methods for initialisation and internal use
+    // These are called from the factories inside this object's monitor
+    // and also from other objects' monitors, e.g. by PageMap::invokeMmapMany.
+    // Hence, the heap and the pool are protected by heapMutex.
     optional<void*> alloc(size_t length, size_t alignment) override;
     optional<void> alloc(MemoryDescriptor* begin, MemoryDescriptor* end) override;
     void free(void* ptr, size_t length) override;
     void free(MemoryDescriptor* begin, MemoryDescriptor* end) override;
+    optional<void*> allocZeroed(size_t length, size_t alignment) override;
+
+  public: // pool of pre-zeroed blocks
+    /** true if the pool of pre-zeroed blocks is below its capacity.
+     * Just a hint, the pool can change concurrently. */
+    bool needsRefill() const { return pool.missing(); }
+
+    /** adds one pre-zeroed block to the pool. The block is taken
+     * from the heap inside the monitor and zeroed on the given place
+     * outside of the monitor. Does nothing if a refill is pending
+     * already or if less than REFILL_RESERVE bytes would remain free
+     * behind the block. Intended for idle hardware threads, see
+     * event::idleThread.
+     */
+    void refillZeroed(async::Place& place);
 
   public: // IAsyncFree interface
     void free(Tasklet* t, IResult<void>* r,
@@ -100,13 +121,56 @@ namespace mythos {
     Error invokeCreate(Tasklet* t, Cap self, IInvocation* msg);
 
   private:
+    /** allocates from the heap and falls back to draining the pool
+     * of pre-zeroed blocks if the heap is exhausted. Needs heapMutex. */
+    optional<uintptr_t> heapAlloc(size_t length, size_t alignment);
+    bool drainPool();
+
+    /** intrusive stack of zeroed blocks of a single size. The first
+     * word of each block links to the next block and is cleared when
+     * the block is handed out. Accessed only with heapMutex, except
+     * for the approximate count.
+     */
+    struct ZeroPool {
+      struct Block { Block* next; };
+      ZeroPool(size_t size, size_t capacity) : size(size), capacity(capacity) {}
+      bool fits(size_t length, size_t alignment) const {
+        return length <= size && alignment <= size;
+      }
+      bool missing() const { return count.load(std::memory_order_relaxed) < capacity; }
+      void push(void* ptr) {
+        auto block = static_cast<Block*>(ptr);
+        block->next = head;
+        head = block;
+        count.store(count.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+      }
+      void* pull() {
+        auto block = head;
+        if (block == nullptr) return nullptr;
+        head = block->next;
+        block->next = nullptr;
+        count.store(count.load(std::memory_order_relaxed)-1, std::memory_order_relaxed);
+        return block;
+      }
+      Block* head = nullptr;
+      std::atomic<size_t> count = {0};
+      size_t const size;
+      size_t const capacity;
+    };
+
     LinkedList<IKernelObject*>::Queueable del_handle = {this};
     IAsyncFree* _parent;
     FirstFitHeap<uintptr_t> heap;
     Range<uintptr_t> _range; //< for rangeProvided()
     /** for deletion: the managed range and then the own object */
     std::array<MemoryDescriptor, 2> _memory;
-    async::NestedMonitorDelegating monitor;
+    async::ObjectMonitor monitor;
+    ThreadMutex heapMutex; //< protects heap and pool, see the IAllocator interface
+
+    constexpr static size_t REFILL_RESERVE = 16*align4K;
+    ZeroPool pool = {align4K, 32}; //< for page tables and small objects
+    std::atomic<bool> refilling = {false};
+    Tasklet refillTask;
   };
 
 class KernelMemoryFactory : public FactoryBase
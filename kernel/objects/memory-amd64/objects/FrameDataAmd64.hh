@@ -97,6 +97,7 @@ namespace mythos {
    * We use bits 52--62 for a partial pointer to the table's PageMap object.
    * We use bit 8 for mapped tables to tell that recursive operations can modify the referenced table.
    * We use bit 8 for mapped frames to tell that the frame capability was writable.
+   * We use bit 10 for mapped frames that get a private copy on the first write.
    */
   BITFIELD_DEF(uint64_t, PageTableEntry)
   enum Config { MAXPHYADDR = 40 };
@@ -112,6 +113,7 @@ namespace mythos {
   BoolField<value_t, base_t, 12> pat2; // for 2MiB and 1GiB pages the bits 12--20 are not needed, bit 12 contains the PAT flag
   UIntField<value_t, base_t, 12, (MAXPHYADDR - 12)> addr;
   BoolField<value_t, base_t, 9> configurable; // MyThOS page table: can modify the mapped table, MYTHOS page: has write access rights
+  BoolField<value_t, base_t, 10> copyOnWrite; // MyThOS page: read-only until the first write fault
   UIntField<value_t, base_t, 52, 10> pmPtr; // MyThOS: table's partial IPageMap* in first 3 entries
   BoolField<value_t, base_t, 63> executeDisabled;
   std::atomic<uint64_t> atomic; // atomic variant for compare-exchange
@@ -144,6 +146,7 @@ namespace mythos {
     if (e.accessed) o << " A";
     if (e.dirty) o << " D";
     if (e.configurable) o << " MC";
+    if (e.copyOnWrite) o << " COW";
     o << '>';
     return o;
   }
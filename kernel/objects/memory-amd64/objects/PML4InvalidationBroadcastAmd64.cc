@@ -32,41 +32,46 @@
 namespace mythos {
 
   PML4InvalidationBroadcast PML4InvalidationBroadcast::nodes[MYTHOS_MAX_THREADS];
+  async::ObjectMonitor PML4InvalidationBroadcast::monitor;
+  async::Place* PML4InvalidationBroadcast::starter = nullptr;
+  Tasklet* PML4InvalidationBroadcast::request = nullptr;
+  IResult<void>* PML4InvalidationBroadcast::result = nullptr;
+  PhysPtr<void> PML4InvalidationBroadcast::pml4;
 
   void PML4InvalidationBroadcast::init()
   {
-    for (cpu::ThreadID id = 0; id < cpu::getNumThreads(); ++id) {
-      /// @todo not needed with linear thread id!
-      nodes[id].next = &nodes[(id+1)%cpu::getNumThreads()];
-      nodes[id].home = async::getPlace(id);
-    }
+    initTree(nodes);
   }
 
-  void PML4InvalidationBroadcast::run(Tasklet* t, IResult<void>* res, PhysPtr<void> pml4)
+  void PML4InvalidationBroadcast::run(Tasklet* t, IResult<void>* res, PhysPtr<void> table)
   {
-    MLOG_DETAIL(mlog::cap, "start pml4 invalidation broadcast");
-    PML4InvalidationBroadcast* start = &nodes[cpu::getThreadID()];
-    start->broadcast(t, res, pml4, start);
+    monitor.request(t, [=](Tasklet* t) {
+        MLOG_DETAIL(mlog::cap, "start pml4 invalidation broadcast");
+        starter = &getLocalPlace();
+        request = t;
+        result = res;
+        pml4 = table;
+        startRound();
+      });
   }
 
-  void PML4InvalidationBroadcast::broadcast(Tasklet* t, IResult<void>* res, PhysPtr<void> pml4, PML4InvalidationBroadcast* start)
+  void PML4InvalidationBroadcast::visitLocal()
   {
-    // invalidate if neccessary
     PhysPtr<void> kernel_pml4(boot::table_to_phys_addr(boot::pml4_table, 1));
     if (getLocalPlace().getCR3() == pml4) {
+      MLOG_DETAIL(mlog::cap, "invalidate pml4");
       getLocalPlace().setCR3(kernel_pml4);
     }
-    // propagate
-    PML4InvalidationBroadcast* pnext = this->next;
-    while (pnext != start && pnext->home->getCR3() != pml4) pnext = pnext->next;
-    if (pnext != start) {
-      MLOG_DETAIL(mlog::cap, "relay pml4 invalidation");
-      pnext->home->run(t->set( [=](Tasklet* t){ pnext->broadcast(t, res, pml4,  start); } ));
-    } else {
-      MLOG_DETAIL(mlog::cap, "end pml4 invalidation");
-      res->response(t);
-    }
   }
 
-} // namespace mythos
+  void PML4InvalidationBroadcast::finished()
+  {
+    MLOG_DETAIL(mlog::cap, "end pml4 invalidation");
+    auto res = result;
+    starter->run(request->set([res](Tasklet* t) {
+          monitor.requestDone();
+          res->response(t);
+        }));
+  }
 
+} // namespace mythos
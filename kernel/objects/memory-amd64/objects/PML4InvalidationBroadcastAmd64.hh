@@ -27,26 +27,39 @@
 
 #include "async/Place.hh"
 #include "async/IResult.hh"
+#include "async/ObjectMonitor.hh"
+#include "objects/BroadcastTree.hh"
 #include "objects/mlog.hh"
 
 namespace mythos {
 
   class Tasklet;
 
+/** Replaces a PML4 that is about to be deleted by the kernel's
+ * default PML4 on all places that have it loaded. The rounds use the
+ * BroadcastTree and visit only places with this PML4 loaded.
+ * Concurrent broadcasts are serialised through the monitor.
+ */
 class PML4InvalidationBroadcast
+  : public BroadcastTree<PML4InvalidationBroadcast>
 {
 public:
-  PML4InvalidationBroadcast() : next(nullptr), home(nullptr) {}
   static void init();
   static void run(Tasklet* t, IResult<void>* res, PhysPtr<void>);
 
 private:
-  void broadcast(Tasklet* t, IResult<void>* res, PhysPtr<void>, PML4InvalidationBroadcast* start);
+  friend class BroadcastTree<PML4InvalidationBroadcast>;
+  bool mustVisit() const { return home->getCR3() == pml4; }
+  void visitLocal();
+  static void finished();
 
 private:
-  PML4InvalidationBroadcast* next;
-  async::Place* home;
   static PML4InvalidationBroadcast nodes[];
+  static async::ObjectMonitor monitor;
+  static async::Place* starter;
+  static Tasklet* request;
+  static IResult<void>* result;
+  static PhysPtr<void> pml4; //< the table to invalidate in the current round
 };
 
 } // namespace mythos
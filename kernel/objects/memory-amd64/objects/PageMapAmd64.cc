@@ -32,6 +32,7 @@
 #include "objects/TypedCap.hh"
 #include "objects/FrameDataAmd64.hh"
 #include "objects/PML4InvalidationBroadcastAmd64.hh"
+#include "objects/TLBShootdownBroadcastAmd64.hh"
 #include "boot/pagetables.hh"
 #include "objects/mlog.hh"
 
@@ -44,8 +45,7 @@ namespace mythos {
     _memDesc[0] = MemoryDescriptor(tableMem, FrameSize::PAGE_MIN_SIZE);
     _memDesc[1] = MemoryDescriptor(capMem, sizeof(CapEntry)*num_caps());
     _memDesc[2] = MemoryDescriptor(this, sizeof(PageMap));
-    memset(_memDesc[0].ptr, 0, _memDesc[0].size);
-    memset(_memDesc[1].ptr, 0, _memDesc[1].size);
+    // both tables were allocated pre-zeroed by the factory
     if (isRootMap()) {
       memcpy(&_pm_table(TABLE_SIZE/2), &boot::pml4_table[TABLE_SIZE/2],
              TABLE_SIZE/2*sizeof(PageTableEntry));
@@ -115,6 +115,8 @@ namespace mythos {
         ASSERT_MSG(res, "Mapped entries must be deletable.");
         if (!res) RETHROW(res);
       }
+      auto res = del.deleteEntry(_cowPool);
+      if (!res) RETHROW(res);
       del.deleteObject(del_handle);
     }
     RETURN(Error::SUCCESS);
@@ -183,6 +185,7 @@ namespace mythos {
     uintptr_t frameaddr = frameInfo.start.physint() + offset;
     if (frameaddr % pageSize() != 0) THROW(Error::PAGEMAP_MISSING);
     if (offset + pageSize() > frameInfo.size) THROW(Error::INSUFFICIENT_RESOURCES);
+    if (flags.copy_on_write && frameInfo.device) THROW(Error::INVALID_ARGUMENT); // the kernel cannot copy it
     MLOG_DETAIL(mlog::cap, "mapFrame checks done");
 
     // build entry: page flag only valid on PML2 and higher
@@ -190,12 +193,13 @@ namespace mythos {
     /// @todo what about write_combine? (PAT/PAT2)
     auto pme = &_pm_table(index);
     auto entry = PageTableEntry().present(true).userMode(true).page(level() > 1)
-      .writeable(flags.writable && frameInfo.writable)
+      .writeable(flags.writable && frameInfo.writable && !flags.copy_on_write)
       //.executeDisabled(!flags.executable) // not working on KNC???
       .writeThrough(flags.write_through)
       .cacheDisabled(flags.cache_disabled)
       .withAddr(frameaddr)
       .configurable(frameInfo.writable)
+      .copyOnWrite(flags.copy_on_write && flags.writable) // read-only mappings are never copied
       .pmPtr(pme->pmPtr);
 
     // inherit
@@ -221,7 +225,7 @@ namespace mythos {
     PageTableEntry pme = table[index].load(); // atomic load of the entry for later compare_exchange!
     // no assert here because the table could have been modified since the previous check!
     if (!pme.present || !pme.page) THROW(Error::LOST_RACE);
-    auto entry = pme.writeable(flags.writable && pme.configurable)
+    auto entry = pme.writeable(flags.writable && pme.configurable && !pme.copyOnWrite)
       //.executeDisabled(!req.executable) // TODO not working on KNC
       .writeThrough(flags.write_through)
       .cacheDisabled(flags.cache_disabled);
@@ -330,6 +334,18 @@ namespace mythos {
     RETURN(res.state());
   }
 
+  void PageMap::mapFrame(Tasklet* t, IResult<void>* r, MapFrameRequest* req)
+  {
+    monitor.acquireRef(); // delays the deletion until the request is done
+    monitor.request(t, [=](Tasklet* t){
+        auto res = this->mapFrame(req->vaddr, req->size, req->frameEntry, req->flags, req->offset,
+                                  &req->failaddr, &req->faillevel);
+        r->response(t, res);
+        monitor.requestDone();
+        monitor.releaseRef();
+      });
+  }
+
   Error PageMap::invokeMmap(Tasklet*, Cap self, IInvocation* msg)
   {
     PageMapData pd(self);
@@ -415,17 +431,175 @@ namespace mythos {
     return res.state();
   }
 
+  optional<void> PageMap::installMissingMap(IInvocation* msg, CapEntry* memEntry, CapPtr dstPtr,
+                                            uintptr_t vaddr, size_t level, MapFlags flags)
+  {
+    vaddr = round_down(vaddr, pageSize(level));
+    // do not replace a mapped page that just blocked an unaligned mapping
+    EmptyEntryVisitor probe(vaddr, level);
+    auto empty = visitTables(&_pm_table(0), this->level(), probe);
+    if (!empty) RETHROW(empty);
+
+    TypedCap<IAllocator> mem(memEntry);
+    if (!mem) RETHROW(mem);
+    auto dstEntry = msg->lookupEntry(dstPtr, 32, true); // lookup for write access
+    if (!dstEntry) RETHROW(dstEntry);
+    if (!dstEntry->acquire()) THROW(Error::LOST_RACE);
+    auto table = PageMapFactory::factory(*dstEntry, memEntry, mem.cap(), *mem, level-1);
+    if (!table) RETHROW(table);
+
+    uintptr_t failaddr;
+    size_t faillevel;
+    RETURN(this->mapTable(vaddr, level, *dstEntry, flags, &failaddr, &faillevel));
+  }
+
+  Error PageMap::invokeMmapMany(Tasklet*, Cap self, IInvocation* msg)
+  {
+    PageMapData pd(self);
+    if (!pd.writable) return Error::REQUEST_DENIED;
+    auto data = msg->getMessage()->read<protocol::PageMap::MmapMany>();
+    if (data.count > data.MAX_MAPPINGS) return Error::INVALID_ARGUMENT;
+    auto memEntry = msg->lookupEntry(data.kmem());
+
+    uintptr_t failaddr = 0;
+    size_t faillevel = 0;
+    uint32_t mapped = 0;
+    uint32_t tables = 0;
+    optional<void> res(Error::SUCCESS);
+    for (; mapped < data.count; mapped++) {
+      auto const& m = data.mappings[mapped];
+      auto frameEntry = msg->lookupEntry(m.frame);
+      if (!frameEntry) { res = frameEntry; break; }
+      uintptr_t vaddr = m.vaddr;
+      size_t size = m.size;
+      size_t offset = m.offset;
+      while (true) {
+        res = this->mapFrame(vaddr, size, *frameEntry, m.flags, offset, &failaddr, &faillevel);
+        if (res || res.state() != Error::PAGEMAP_MISSING || faillevel < 2) break;
+        if (tables >= data.numTables()) break; // no slot left for another page map
+        if (!memEntry) { res = memEntry; break; }
+        auto installed = installMissingMap(msg, *memEntry, data.table(tables),
+                                           failaddr, faillevel, data.tableFlags);
+        if (!installed) { res = installed; break; }
+        tables++;
+        // continue behind the pages that are mapped already
+        offset += failaddr - vaddr;
+        size -= failaddr - vaddr;
+        vaddr = failaddr;
+      }
+      if (!res) break;
+    }
+    MLOG_DETAIL(mlog::cap, "mmapMany", DVAR(data.count), DVAR(mapped), DVAR(tables), DVAR(res.state()));
+    msg->getMessage()->write<protocol::PageMap::MmapManyResult>(failaddr, faillevel, mapped, tables);
+    return res.state();
+  }
+
+  bool PageMap::resolveFault(Tasklet* t, IResult<void>* r, uintptr_t vaddr)
+  {
+    // find the entry without visitor, the page maps cannot be deleted concurrently
+    // because of the delete synchronisation broadcast.
+    PageTableEntry* table = &_pm_table(0);
+    size_t lvl = level();
+    size_t index = (vaddr / pageSize(lvl)) % TABLE_SIZE;
+    while (true) {
+      auto pme = table[index].load();
+      if (lvl == 1 || !pme.present || pme.page) break;
+      // copying the page does not help against a read-only table on the way
+      if (!pme.configurable || !pme.writeable) return false;
+      table = phys2kernel<PageTableEntry>(pme.getAddr());
+      lvl--;
+      index = (vaddr / pageSize(lvl)) % TABLE_SIZE;
+    }
+    auto pme = table[index].load();
+    MLOG_DETAIL(mlog::cap, "resolveFault", DVARhex(vaddr), DVAR(lvl), DVAR(pme));
+    if (!pme.present || !(pme.copyOnWrite || pme.writeable)) return false;
+
+    // the entry belongs to the owner, which may be changed concurrently by its invocations
+    auto owner = static_cast<PageMap*>(table2PageMap(table));
+    monitor.acquireRef(); // keeps the copy-on-write pool
+    owner->monitor.acquireRef();
+    owner->monitor.request(t, [=](Tasklet* t){
+        auto res = this->copyPage(owner, index);
+        r->response(t, res);
+        owner->monitor.requestDone();
+        owner->monitor.releaseRef();
+        this->monitor.releaseRef();
+      });
+    return true;
+  }
+
+  optional<void> PageMap::copyPage(PageMap* owner, size_t index)
+  {
+    optional<void> res(Error::SUCCESS);
+    _cowMutex << [&] {
+      auto pme = owner->_pm_table(index).load();
+      if (!pme.present) { res = optional<void>(Error::PAGEMAP_MISSING); return; }
+      // another execution context resolved the fault, the translation is writable by now
+      if (pme.writeable) return;
+      if (!pme.copyOnWrite) { res = optional<void>(Error::REQUEST_DENIED); return; }
+
+      TypedCap<IFrame> pool(_cowPool);
+      if (!pool) { res = pool; return; }
+      auto poolInfo = pool.getFrameInfo();
+      auto size = owner->pageSize();
+      auto offset = round_up(_cowNext, size);
+      if (offset + size > poolInfo.size) { res = optional<void>(Error::INSUFFICIENT_RESOURCES); return; }
+      memcpy(phys2kernel<char>(poolInfo.start.physint() + offset), phys2kernel<char>(pme.getAddr()), size);
+      // the copy keeps the rights and caching of the mapping, only copy-on-write
+      // mappings are writable ones, see mapFrame()
+      auto flags = MapFlags().writable(true).executable(!pme.executeDisabled)
+        .write_through(pme.writeThrough).cache_disabled(pme.cacheDisabled);
+      // replaces the shared frame, the faulting hardware thread dropped the old translation
+      // and the execution context shoots it down on the others, see shootdown()
+      res = owner->mapFrame(index, &_cowPool, flags, offset);
+      if (res) _cowNext = offset + size;
+    };
+    return res;
+  }
+
+  bool PageMap::shootdown(Tasklet* t, IResult<void>* r, uintptr_t vaddr)
+  {
+    auto table = PhysPtr<void>::fromKernel(&_pm_table(0));
+    if (!isRootMap() || !TLBShootdownBroadcast::needed(table)) return false;
+    TLBShootdownBroadcast::run(t, r, table, vaddr);
+    return true;
+  }
+
+  Error PageMap::invokeSetCowPool(Tasklet*, Cap self, IInvocation* msg)
+  {
+    PageMapData pd(self);
+    if (!pd.writable) return Error::REQUEST_DENIED;
+    if (!isRootMap()) return Error::INVALID_CAPABILITY;
+    auto data = msg->getMessage()->read<protocol::PageMap::SetCowPool>();
+    optional<void> res(Error::SUCCESS);
+    _cowMutex << [&] {
+      cap::resetReference(_cowPool);
+      _cowNext = 0;
+      if (data.frame() == null_cap) return;
+      auto frameEntry = msg->lookupEntry(data.frame());
+      if (!frameEntry) { res = frameEntry; return; }
+      TypedCap<IFrame> frame(*frameEntry);
+      if (!frame) { res = frame; return; }
+      auto info = frame.getFrameInfo();
+      if (info.device || !info.writable) { res = optional<void>(Error::INVALID_CAPABILITY); return; }
+      // references need a power of two size, the rest of the frame stays unused
+      auto req = protocol::Frame::FrameReq().writable(true).size(info.size);
+      res = cap::reference(**frameEntry, _cowPool, frame.cap(), req);
+    };
+    return res.state();
+  }
+
   optional<PageMap*>
   PageMapFactory::factory(CapEntry* dstEntry, CapEntry* memEntry, Cap memCap, IAllocator* mem,
                          size_t level)
   {
     if (!(level>=1 && level<=4)) THROW(Error::INVALID_ARGUMENT);
-    auto table = mem->alloc(FrameSize::PAGE_MIN_SIZE, FrameSize::PAGE_MIN_SIZE);
+    auto table = mem->allocZeroed(FrameSize::PAGE_MIN_SIZE, FrameSize::PAGE_MIN_SIZE);
     if (!table) {
       dstEntry->reset();
       RETHROW(table);
     }
-    auto caps = mem->alloc(sizeof(CapEntry)*PageMap::num_caps(level), FrameSize::PAGE_MIN_SIZE);
+    auto caps = mem->allocZeroed(sizeof(CapEntry)*PageMap::num_caps(level), FrameSize::PAGE_MIN_SIZE);
     if (!caps) {
       mem->free(*table, FrameSize::PAGE_MIN_SIZE);
       dstEntry->reset();
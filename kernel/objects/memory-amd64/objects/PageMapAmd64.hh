@@ -31,8 +31,9 @@
 #include "objects/FrameDataAmd64.hh"
 #include "objects/IKernelObject.hh"
 #include "objects/CapEntry.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "mythos/protocol/PageMap.hh"
+#include "util/ThreadMutex.hh"
 
 namespace mythos {
 
@@ -71,9 +72,12 @@ public: // IPageMap interface
                                    uintptr_t* failaddr, size_t* faillevel) override; 
   optional<void> mapTable(uintptr_t vaddr, size_t level, CapEntry* tableEntry, MapFlags flags,
                                     uintptr_t* failaddr, size_t* faillevel) override;
+  void mapFrame(Tasklet* t, IResult<void>* r, MapFrameRequest* req) override;
   optional<void> mapFrame(size_t index, CapEntry* frameEntry, MapFlags flags, size_t offset) override;
   optional<void> unmapEntry(size_t index) override;
   optional<void> mapTable(CapEntry* table, MapFlags req, size_t index) override;
+  bool resolveFault(Tasklet* t, IResult<void>* r, uintptr_t vaddr) override;
+  bool shootdown(Tasklet* t, IResult<void>* r, uintptr_t vaddr) override;
 
 
   /** visitor state for operations on pages: mapFrame, unmapFrame, protectPage. */ 
@@ -161,6 +165,22 @@ public: // IPageMap interface
     optional<void> applyTable(IPageMap* map, size_t index) override { return map->unmapEntry(index); }
   };
 
+  /** fails with CAP_NONEMPTY if something is mapped at the target entry. */
+  struct EmptyEntryVisitor : public TableOp {
+    EmptyEntryVisitor(uintptr_t vaddr, size_t target_level)
+      : TableOp(vaddr, target_level) {}
+    optional<void> applyTable(IPageMap* map, size_t index) override {
+      if (static_cast<PageMap*>(map)->_pm_table(index).load().present) THROW(Error::CAP_NONEMPTY);
+      RETURN(Error::SUCCESS);
+    }
+  };
+
+  /** allocates a page map for the empty entry at vaddr in the table of the given level
+   * and installs it there. Used by invokeMmapMany. This runs in the page map's monitor,
+   * the kernel memory protects its heap with its own mutex. */
+  optional<void> installMissingMap(IInvocation* msg, CapEntry* memEntry, CapPtr dstPtr,
+                                   uintptr_t vaddr, size_t level, MapFlags flags);
+
   
 public:
   /** IResult<optional> interface, used for shootdown. */
@@ -184,6 +204,8 @@ public: // IKernelObject interface
   Error invokeMprotect(Tasklet* t, Cap self, IInvocation* msg);
   Error invokeInstallMap(Tasklet* t, Cap self, IInvocation* msg);
   Error invokeRemoveMap(Tasklet* t, Cap self, IInvocation* msg);
+  Error invokeMmapMany(Tasklet* t, Cap self, IInvocation* msg);
+  Error invokeSetCowPool(Tasklet* t, Cap self, IInvocation* msg);
 
 private:
   class MappedFrame : public IKernelObject {
@@ -221,11 +243,17 @@ private:
     return *(reinterpret_cast<CapEntry*>(_memDesc[1].ptr)+index);
   }
 
-  async::NestedMonitorDelegating monitor;
+  async::ObjectMonitor monitor;
   IAsyncFree* _mem;
   IDeleter::handle_t del_handle = {this};
 
   IResult<void>* _deletionSink;
+
+  /** reference to the frame that provides the copies of copy-on-write pages, root map only. */
+  CapEntry _cowPool;
+  size_t _cowNext = 0; //< offset of the next free page in the pool
+  ThreadMutex _cowMutex; //< serialises the fault resolution, protects _cowNext
+  optional<void> copyPage(PageMap* owner, size_t index);
   optional<void> _Obj(IDeleter& del);
 
   // not used anymore?
@@ -0,0 +1,87 @@
+/* -*- mode:C++; indent-tabs-mode:nil; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include "objects/TLBShootdownBroadcastAmd64.hh"
+
+#include "cpu/hwthreadid.hh"
+#include "cpu/ctrlregs.hh"
+
+namespace mythos {
+
+  TLBShootdownBroadcast TLBShootdownBroadcast::nodes[MYTHOS_MAX_THREADS];
+  async::ObjectMonitor TLBShootdownBroadcast::monitor;
+  async::Place* TLBShootdownBroadcast::starter = nullptr;
+  Tasklet* TLBShootdownBroadcast::request = nullptr;
+  IResult<void>* TLBShootdownBroadcast::result = nullptr;
+  PhysPtr<void> TLBShootdownBroadcast::pml4;
+  uintptr_t TLBShootdownBroadcast::page = 0;
+
+  void TLBShootdownBroadcast::init()
+  {
+    initTree(nodes);
+  }
+
+  bool TLBShootdownBroadcast::needed(PhysPtr<void> table)
+  {
+    // the page table entry was changed before, places that load the PML4 from now on are fine
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto self = &getLocalPlace();
+    for (cpu::ThreadID id = 0; id < cpu::getNumThreads(); id++) {
+      auto place = async::getPlace(id);
+      if (place != self && place->getCR3() == table) return true;
+    }
+    return false;
+  }
+
+  void TLBShootdownBroadcast::run(Tasklet* t, IResult<void>* res, PhysPtr<void> table, uintptr_t vaddr)
+  {
+    monitor.request(t, [=](Tasklet* t) {
+        MLOG_DETAIL(mlog::cap, "start tlb shootdown broadcast", DVARhex(vaddr));
+        starter = &getLocalPlace();
+        request = t;
+        result = res;
+        pml4 = table;
+        page = vaddr;
+        startRound();
+      });
+  }
+
+  void TLBShootdownBroadcast::visitLocal()
+  {
+    if (getLocalPlace().getCR3() == pml4) cpu::flushTLB(reinterpret_cast<void*>(page));
+  }
+
+  void TLBShootdownBroadcast::finished()
+  {
+    MLOG_DETAIL(mlog::cap, "end tlb shootdown");
+    auto res = result;
+    starter->run(request->set([res](Tasklet* t) {
+          monitor.requestDone();
+          res->response(t);
+        }));
+  }
+
+} // namespace mythos
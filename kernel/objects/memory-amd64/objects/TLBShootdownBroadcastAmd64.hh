@@ -0,0 +1,70 @@
+/* -*- mode:C++; indent-tabs-mode:nil; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include "async/Place.hh"
+#include "async/IResult.hh"
+#include "async/ObjectMonitor.hh"
+#include "objects/BroadcastTree.hh"
+#include "objects/mlog.hh"
+
+namespace mythos {
+
+  class Tasklet;
+
+/** Invalidates the TLB entry of one page on all other places that have
+ * the given PML4 loaded. Places that load the PML4 later do not cache
+ * the old translation. The rounds use the BroadcastTree and visit only
+ * places with this PML4 loaded. Concurrent broadcasts are serialised
+ * through the monitor.
+ */
+class TLBShootdownBroadcast
+  : public BroadcastTree<TLBShootdownBroadcast>
+{
+public:
+  static void init();
+
+  /** true if another place has the PML4 loaded and a round is needed */
+  static bool needed(PhysPtr<void> table);
+  static void run(Tasklet* t, IResult<void>* res, PhysPtr<void> table, uintptr_t vaddr);
+
+private:
+  friend class BroadcastTree<TLBShootdownBroadcast>;
+  bool mustVisit() const { return home->getCR3() == pml4; }
+  void visitLocal();
+  static void finished();
+
+private:
+  static TLBShootdownBroadcast nodes[];
+  static async::ObjectMonitor monitor;
+  static async::Place* starter;
+  static Tasklet* request;
+  static IResult<void>* result;
+  static PhysPtr<void> pml4; //< the address space of the current round
+  static uintptr_t page; //< the virtual address to invalidate in the current round
+};
+
+} // namespace mythos
@@ -31,7 +31,7 @@
 #include "objects/IPortal.hh"
 #include "objects/IFrame.hh"
 #include "objects/IFactory.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/CapRef.hh"
 #include "objects/mlog.hh"
 #include "objects/RevokeOperation.hh"
@@ -156,7 +156,7 @@ namespace mythos {
     IAsyncFree* memory;
     RevokeOperation revokeOp = {monitor};
     Tasklet rootTask; //< start of one logical control flow per portal
-    async::NestedMonitorDelegating monitor;
+    async::ObjectMonitor monitor;
   };
 
   class PortalFactory : public FactoryBase
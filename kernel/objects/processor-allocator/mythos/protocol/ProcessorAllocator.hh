@@ -42,12 +42,17 @@ namespace mythos {
 
       struct Alloc : public InvocationBase {
         constexpr static uint16_t label = (proto<<8) + ALLOC;
-        Alloc(CapPtr dstMap = null_cap) : InvocationBase(label,getLength(this)) {
+        constexpr static uint32_t ANY_THREAD = uint32_t(-1);
+        Alloc(CapPtr dstMap = null_cap, uint32_t thread = ANY_THREAD)
+          : InvocationBase(label,getLength(this)), thread(thread) {
           addExtraCap(dstMap);
         }
 
         // target cap map
         CapPtr dstSpace() const { return this->capPtrs[0]; }
+
+        // requested hardware thread or ANY_THREAD
+        uint32_t thread;
       };
 
       struct RetAlloc : public InvocationBase {
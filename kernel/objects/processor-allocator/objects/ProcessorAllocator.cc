@@ -81,13 +81,15 @@ namespace mythos {
 
   Error ProcessorAllocator::invokeAlloc(Tasklet*, Cap, IInvocation* msg){
     MLOG_DETAIL(mlog::pm, __func__);
-    auto id = alloc();
+    auto data = msg->getMessage()->read<protocol::ProcessorAllocator::Alloc>();
+    optional<cpu::ThreadID> id;
+    if (data.thread == protocol::ProcessorAllocator::Alloc::ANY_THREAD) id = alloc();
+    else if (data.thread < cpu::getNumThreads()) id = alloc(cpu::ThreadID(data.thread));
+    else return Error::INVALID_ARGUMENT;
 
     if(id){
       MLOG_DETAIL(mlog::pm, "allocated ", DVAR(*id));
 
-      auto data = msg->getMessage()->read<protocol::ProcessorAllocator::Alloc>();
-
       optional<CapEntry*> dstEntry;
       if(data.dstSpace() == null_cap){ // direct access
         dstEntry = msg->lookupEntry(init::SCHEDULERS_START+*id, 32, true); // lookup for write access
@@ -170,6 +172,18 @@ namespace mythos {
     return ret;
   }
 
+  optional<cpu::ThreadID> LiFoProcessorAllocator::alloc(cpu::ThreadID id){
+    optional<cpu::ThreadID> ret;
+    for (unsigned i = 0; i < nFree; i++) {
+      if (freeList[i] != id) continue;
+      nFree--;
+      freeList[i] = freeList[nFree];
+      ret = id;
+      break;
+    }
+    return ret;
+  }
+
   void LiFoProcessorAllocator::free(cpu::ThreadID id) {
       freeList[nFree] = id;
       nFree++;
@@ -25,7 +25,7 @@
  */
 #pragma once
 
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/IFactory.hh"
 #include "objects/IKernelObject.hh"
 #include "cpu/hwthreadid.hh"
@@ -59,11 +59,13 @@ class ProcessorAllocator
   protected:
     friend class PluginProcessorAllocator;
     virtual optional<cpu::ThreadID> alloc() = 0;
+    /** takes a specific hardware thread, fails if it is not free. */
+    virtual optional<cpu::ThreadID> alloc(cpu::ThreadID id) = 0;
     virtual void free(cpu::ThreadID id) = 0;
     virtual unsigned numFree() = 0;
 
   private:
-    async::NestedMonitorDelegating monitor;
+    async::ObjectMonitor monitor;
     RevokeOperation revokeOp = {monitor};
     cpu::ThreadID toBeFreed = 0;
     CapEntry *sc;
@@ -77,6 +79,7 @@ class LiFoProcessorAllocator : public ProcessorAllocator
 
     unsigned numFree() override { return nFree; }
     optional<cpu::ThreadID> alloc() override; 
+    optional<cpu::ThreadID> alloc(cpu::ThreadID id) override;
     void free(cpu::ThreadID id) override;
 
   private:
@@ -35,6 +35,7 @@
 
 namespace mythos {
     Event<Tasklet*, cpu::ThreadID> event::idleSC;
+    Event<cpu::ThreadID> event::idleThread;
 
     void SchedulingContext::bind(handle_t*) 
     {
@@ -45,7 +46,9 @@ namespace mythos {
         ASSERT(ec != nullptr);
         MLOG_INFO(mlog::sched, "unbind", DVAR(ec->get()));
         readyQueue.remove(ec);
-        current_handle.store(nullptr);
+        // deselect only if it is this execution context, another one may be selected already
+        auto expected = ec;
+        current_handle.compare_exchange_strong(expected, nullptr);
         if(readyQueue.empty()){
           MLOG_DETAIL(mlog::sched, "call idleSC");
           event::idleSC.emit(&paTask, home->getThreadID());
@@ -97,6 +100,7 @@ namespace mythos {
             if (next == nullptr) {
                 // go sleeping because we don't have anything to run
                 MLOG_DETAIL(mlog::sched, "empty ready list, going to sleep");
+                event::idleThread.emit(home->getThreadID());
                 return;
             }
             current_handle.store(next);
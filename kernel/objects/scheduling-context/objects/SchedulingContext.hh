@@ -86,6 +86,7 @@ namespace mythos {
     void bind(handle_t* ec_handle) override;
     void unbind(handle_t* ec_handle) override;
     void ready(handle_t* ec_handle) override;
+    async::Place* getHome() const override { return home; }
 
   public: // IKernelObject interface
     optional<void> deleteCap(CapEntry&, Cap, IDeleter&) override { RETURN(Error::SUCCESS); }
@@ -104,5 +105,11 @@ namespace mythos {
 
   namespace event {
     extern Event<Tasklet*, cpu::ThreadID> idleSC;
+
+    /** emitted when a hardware thread found no execution context to
+     * run and is about to sleep. The hooks run outside of the task
+     * processing, thus they have to use Place::pushShared for kernel
+     * work, which wakes the hardware thread again. */
+    extern Event<cpu::ThreadID> idleThread;
   }
 } // namespace mythos
@@ -27,7 +27,7 @@
 
 #include <array>
 #include <cstddef>
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/IFactory.hh"
 #include "objects/IKernelObject.hh"
 #include "objects/CapEntry.hh"
@@ -114,7 +114,7 @@ protected:
   Signal _signal = 0;
   KEvent::Context _context = 0;
 
-  async::NestedMonitorDelegating monitor;
+  async::ObjectMonitor monitor;
   IDeleter::handle_t del_handle = {this};
   IAsyncFree* _mem;
   friend class SignalListenerFactory;
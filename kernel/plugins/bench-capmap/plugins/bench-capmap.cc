@@ -0,0 +1,97 @@
+/* -*- mode:C++; indent-tabs-mode:nil; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include "plugins/Plugin.hh"
+#include "objects/CapMap.hh"
+#include "objects/KernelMemory.hh"
+#include "boot/memory-root.hh"
+#include "boot/mlog.hh"
+#include "mythos/InfoFrame.hh"
+
+namespace mythos {
+
+  /** Measures capability lookups in a flat capability space, as used by
+   * most processes, and in a space with one nested map. The results
+   * are converted to lookups per second with the default length of a
+   * time stamp counter tick.
+   */
+  class BenchCapMap
+    : public Plugin
+  {
+  public:
+    static constexpr size_t ROUNDS = 1000000;
+
+    static uint64_t rdtsc() {
+      uint32_t low, high;
+      asm volatile("rdtsc" : "=a" (low), "=d" (high));
+      return (uint64_t(high) << 32) | low;
+    }
+
+    void measure(const char* name, CapMap* map, CapPtr base, size_t count) {
+      auto self = map->getRoot().cap();
+      size_t found = 0;
+      auto start = rdtsc();
+      for (size_t i = 0; i < ROUNDS; i++) {
+        auto ref = map->lookup(self, base + CapPtr(i % count), max_cap_depth, false);
+        if (ref) found++;
+      }
+      auto end = rdtsc();
+      OOPS(found == ROUNDS);
+      auto cycles = (end-start)/ROUNDS;
+      MLOG_ERROR(mlog::boot, "BenchCapMap:", name, "cycles/lookup", cycles,
+                 "lookups/s", 1000000000000ull/(cycles ? cycles*PS_PER_TSC_DEFAULT : 1));
+    }
+
+    void initThread(cpu::ThreadID threadID) override {
+      if (threadID != 0) return;
+      auto memEntry = boot::kmem_root_entry();
+      auto mem = boot::kmem_root();
+
+      // 20 bit guard and 12 bit index like the initial capability space
+      auto flat = CapMapFactory::initial(memEntry, memEntry->cap(), mem,
+                                         CapPtrDepth(12), CapPtrDepth(20), CapPtr(0));
+      if (!flat) {
+        MLOG_ERROR(mlog::boot, "BenchCapMap: not enough memory");
+        return;
+      }
+      measure("flat", *flat, 0, CapMap::cap_count(12));
+
+      // 16 bit guard and 8 bit index, the entry 1 points to a map with another 8 bit index
+      auto root = CapMapFactory::initial(memEntry, memEntry->cap(), mem,
+                                         CapPtrDepth(8), CapPtrDepth(16), CapPtr(0));
+      if (!root) return;
+      auto subEntry = (*root)->get(1);
+      OOPS(subEntry->acquire());
+      auto sub = CapMapFactory::factory(subEntry, memEntry, memEntry->cap(), mem,
+                                        CapPtrDepth(8), CapPtrDepth(0), CapPtr(0));
+      if (!sub) return;
+      measure("nested", *root, CapPtr(1) << 8, CapMap::cap_count(8));
+    }
+  };
+
+  BenchCapMap plugin_BenchCapMap;
+
+} // namespace mythos
@@ -0,0 +1,90 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include "plugins/Plugin.hh"
+#include "async/Place.hh"
+#include "async/NestedMonitorDelegating.hh"
+#include "async/NestedMonitorFastpath.hh"
+#include "boot/mlog.hh"
+#include "cpu/hwthreadid.hh"
+
+namespace mythos {
+
+  /** Compares the monitor implementations in the uncontended case,
+   * which is the common one for per-thread kernel objects. Every
+   * hardware thread hammers its own private object. The request and
+   * its completion are processed inline, hence the measured cycles
+   * are the pure monitor overhead.
+   */
+  class BenchMonitors
+    : public Plugin
+  {
+  public:
+    static constexpr size_t ROUNDS = 100000;
+
+    template<class MONITOR>
+    struct Node {
+      void run(size_t rounds) {
+        for (size_t i=0; i<rounds; i++) {
+          monitor.request(&msg, [this](Tasklet*) {
+              this->counter++;
+              this->monitor.requestDone();
+            });
+        }
+      }
+
+      MONITOR monitor;
+      size_t counter = 0;
+      Tasklet msg;
+    };
+
+    static uint64_t rdtsc() {
+      uint32_t low, high;
+      asm volatile("rdtsc" : "=a" (low), "=d" (high));
+      return (uint64_t(high) << 32) | low;
+    }
+
+    template<class MONITOR>
+    void measure(const char* name, cpu::ThreadID threadID) {
+      Node<MONITOR> node;
+      node.run(ROUNDS/10); // warm up
+      auto start = rdtsc();
+      node.run(ROUNDS);
+      auto end = rdtsc();
+      ASSERT(node.counter == ROUNDS + ROUNDS/10);
+      MLOG_ERROR(mlog::boot, "BenchMonitors:", name, DVAR(threadID),
+                 "cycles/request", (end-start)/ROUNDS);
+    }
+
+    void initThread(cpu::ThreadID threadID) {
+      measure<async::NestedMonitorDelegating>("delegating", threadID);
+      measure<async::NestedMonitorFastpath>("fastpath", threadID);
+    }
+  };
+
+  BenchMonitors plugin_BenchMonitors;
+
+} // namespace mythos
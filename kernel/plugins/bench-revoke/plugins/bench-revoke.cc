@@ -0,0 +1,122 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include <new>
+#include "plugins/Plugin.hh"
+#include "async/Place.hh"
+#include "objects/IKernelObject.hh"
+#include "objects/CapEntry.hh"
+#include "objects/RevokeOperation.hh"
+#include "objects/KernelMemory.hh"
+#include "boot/memory-root.hh"
+#include "boot/mlog.hh"
+
+namespace mythos {
+
+  /** Measures the revocation of large resource trees. The tree is
+   * built from a dummy object whose address range depends on the
+   * position of the capability entry. Thus, the same object yields a
+   * flat tree, where all entries are children of the root, or a
+   * chain, where each entry is the child of its predecessor.
+   */
+  class BenchRevoke
+    : public Plugin
+    , public IResult<void>
+  {
+  public:
+    static constexpr size_t MAX_CHILDREN = 100000;
+
+    struct Dummy : public IKernelObject {
+      Range<uintptr_t> addressRange(CapEntry& entry, Cap) override {
+        uintptr_t idx = &entry - entries;
+        if (idx == 0) return Range<uintptr_t>(0, MAX_CHILDREN+1);
+        if (chain) return Range<uintptr_t>(idx, MAX_CHILDREN+1);
+        return Range<uintptr_t>::bySize(idx, 1);
+      }
+      optional<void const*> vcast(TypeId) const override { THROW(Error::TYPE_MISMATCH); }
+      optional<void> deleteCap(CapEntry&, Cap, IDeleter&) override { RETURN(Error::SUCCESS); }
+
+      CapEntry* entries = nullptr;
+      bool chain = false;
+    };
+
+    BenchRevoke() : op(monitor) {}
+
+    static uint64_t rdtsc() {
+      uint32_t low, high;
+      asm volatile("rdtsc" : "=a" (low), "=d" (high));
+      return (uint64_t(high) << 32) | low;
+    }
+
+    void initThread(cpu::ThreadID threadID) override {
+      if (threadID != 0) return;
+      auto mem = boot::kmem_root()->alloc(sizeof(CapEntry)*(MAX_CHILDREN+1), 64);
+      if (!mem) {
+        MLOG_ERROR(mlog::boot, "BenchRevoke: not enough memory");
+        return;
+      }
+      dummy.entries = new(*mem) CapEntry[MAX_CHILDREN+1];
+      dummy.entries[0].initRoot(Cap(&dummy)); // a revoke keeps the root
+      next();
+    }
+
+    /** builds the next tree and starts its revocation */
+    void next() {
+      if (size > MAX_CHILDREN) {
+        if (dummy.chain) return;
+        dummy.chain = true;
+        size = 100;
+      }
+      auto entries = dummy.entries;
+      for (size_t i = 1; i <= size; i++) {
+        auto parent = dummy.chain ? &entries[i-1] : &entries[0];
+        OOPS(entries[i].acquire());
+        OOPS(cap::inherit(*parent, parent->cap(), entries[i], Cap(&dummy)));
+      }
+      start = rdtsc();
+      op.revokeCap(&msg, this, entries[0], nullptr);
+    }
+
+    void response(Tasklet*, optional<void> res) override {
+      auto end = rdtsc();
+      OOPS(res);
+      MLOG_ERROR(mlog::boot, "BenchRevoke:", dummy.chain ? "chain" : "flat", DVAR(size),
+                 "cycles/child", (end-start)/size);
+      size *= 10;
+      next();
+    }
+
+    Dummy dummy;
+    async::ObjectMonitor monitor;
+    RevokeOperation op;
+    Tasklet msg;
+    size_t size = 100;
+    uint64_t start = 0;
+  };
+
+  BenchRevoke plugin_BenchRevoke;
+
+} // namespace mythos
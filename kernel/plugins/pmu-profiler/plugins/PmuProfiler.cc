@@ -0,0 +1,195 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include "plugins/Plugin.hh"
+#include "util/events.hh"
+#include "util/PhysPtr.hh"
+#include "util/align.hh"
+#include "util/mstring.hh"
+#include "cpu/IrqHandler.hh"
+#include "cpu/kernel_entry.hh"
+#include "cpu/stacktrace.hh"
+#include "cpu/ctrlregs.hh"
+#include "cpu/perfmondefs.hh"
+#include "cpu/PmcState.hh"
+#include "cpu/LAPIC.hh"
+#include "cpu/hwthreadid.hh"
+#include "boot/load_init.hh"
+#include "objects/ISchedulable.hh"
+#include "objects/IFrame.hh"
+#include "objects/TypedCap.hh"
+#include "objects/mlog.hh"
+#include "mythos/init.hh"
+#include "mythos/PmuSamples.hh"
+#include <atomic>
+
+namespace mythos {
+
+  /** Sampling profiler based on the performance monitoring counters.
+   *
+   * The highest general purpose counter is withdrawn from the execution
+   * contexts and counts unhalted core cycles in user and kernel mode on
+   * every hardware thread. Its overflow raises a non-maskable interrupt,
+   * which records the interrupted instruction, the current execution
+   * context, and a few return addresses of the kernel stack into the
+   * hardware thread's ring. The rings are placed in a frame that is handed
+   * to the init application at init::PMU_SAMPLES.
+   */
+  class PluginPmuProfiler
+    : public Plugin
+    , public EventHook<boot::InitLoader&>
+  {
+  public:
+    enum : uint64_t {
+      EVENT_SELECT = 0x3C, // unhalted core cycles
+      PERIOD = 1000000
+    };
+
+    PluginPmuProfiler()
+      : Plugin("pmu profiler"), kernelNmi(this), userNmi(this)
+    {
+      event::initLoader.add(this);
+    }
+    virtual ~PluginPmuProfiler() {}
+
+    void initGlobal() override {
+      auto res = cpu::PmcState::reserveCounter();
+      if (!res) {
+        MLOG_INFO(mlog::perfmon, "pmu profiler disabled, no counter available");
+        return;
+      }
+      counter = uint32_t(*res); // the counter index is below 32
+      nextKernelNmi = irq_kernelbugs[2];
+      irq_kernelbugs[2] = &kernelNmi;
+      nextUserNmi = irq_usernmi;
+      irq_usernmi = &userNmi;
+      enabled = true;
+    }
+
+    /** runs on the booting hardware thread itself. */
+    void initThread(cpu::ThreadID) override {
+      if (!enabled) return;
+      x86::IA32_PERFEVTSELx_Bitfield sel(EVENT_SELECT);
+      sel.usr = true;
+      sel.os = true;
+      sel.intEn = true;
+      sel.en = true;
+      x86::setMSR(x86::IA32_PERFEVTSEL0 + counter, 0);
+      x86::setMSR(x86::IA32_PMC0 + counter, -uint64_t(PERIOD));
+      x86::setMSR(x86::IA32_PERFEVTSEL0 + counter, sel);
+      lapic.enablePerfCounterNMI();
+      x86::setMSR(x86::IA32_PERF_GLOBAL_CTRL,
+                  x86::getMSR(x86::IA32_PERF_GLOBAL_CTRL) | (1ull << counter));
+    }
+
+    void processEvent(boot::InitLoader& loader) override {
+      if (!enabled) return;
+      auto numThreads = cpu::getNumThreads();
+      auto size = round_up(PmuSampleBuffer::size(numThreads), align2M);
+      auto frameCap = loader.memMapper.createFrame(init::PMU_SAMPLES, size, align2M);
+      if (!frameCap) {
+        MLOG_ERROR(mlog::perfmon, "could not allocate sample buffer", DVAR(size));
+        return;
+      }
+      TypedCap<IFrame> frame(loader.capAlloc.get(*frameCap));
+      if (!frame) return;
+      auto buf = reinterpret_cast<PmuSampleBuffer*>(frame.getFrameInfo().start.logint());
+      memset(buf, 0, size);
+      buf->numThreads = numThreads;
+      buf->eventSelect = EVENT_SELECT;
+      buf->period = PERIOD;
+      MLOG_INFO(mlog::perfmon, "pmu profiler sample buffer", DVAR(counter), DVAR(numThreads),
+                DVARhex(size), DVAR(PERIOD));
+      buffer.store(buf, std::memory_order_release);
+    }
+
+  protected:
+    /** checks whether the sampling counter caused the interrupt and
+     * re-arms it. */
+    bool acknowledge() {
+      auto bit = 1ull << counter;
+      if (!(x86::getMSR(x86::IA32_PERF_GLOBAL_STATUS) & bit)) return false;
+      x86::setMSR(x86::IA32_PMC0 + counter, -uint64_t(PERIOD));
+      x86::setMSR(x86::IA32_PERF_GLOBAL_OVF_CTRL, bit);
+      lapic.enablePerfCounterNMI();
+      return true;
+    }
+
+    void sample(uint64_t rip, uint64_t flags, uintptr_t rbp) {
+      auto buf = buffer.load(std::memory_order_acquire);
+      if (!buf) return; // too early, the init application is not loaded yet
+      PmuSample s;
+      s.rip = rip;
+      s.ec = reinterpret_cast<uint64_t>(current_ec->load());
+      s.flags = flags;
+      size_t depth = 0;
+      if (rbp) {
+        for (auto& frame : StackTrace(rbp)) {
+          // the frame pointer may be garbage if we interrupted an entry point
+          if (depth == PmuSample::STACK_DEPTH || !is_aligned(&frame, alignWord)) break;
+          if (!isKernelAddress(&frame) && !isImageAddress(&frame)) break;
+          s.stack[depth++] = reinterpret_cast<uint64_t>(frame.ret);
+        }
+      }
+      for (; depth < PmuSample::STACK_DEPTH; depth++) s.stack[depth] = 0;
+      buf->ring(cpu::getThreadID())->push(s);
+    }
+
+    class KernelNmi : public IIrqHandler<cpu::KernelIRQFrame*>
+    {
+    public:
+      KernelNmi(PluginPmuProfiler* p) : p(p) {}
+      void process(cpu::KernelIRQFrame* ctx) override {
+        if (p->acknowledge()) p->sample(ctx->rip, 0, ctx->rbp);
+        else p->nextKernelNmi->process(ctx);
+      }
+      PluginPmuProfiler* p;
+    };
+
+    class UserNmi : public IIrqHandler<cpu::ThreadState*>
+    {
+    public:
+      UserNmi(PluginPmuProfiler* p) : p(p) {}
+      void process(cpu::ThreadState* ctx) override {
+        if (p->acknowledge()) p->sample(ctx->rip, PmuSample::USER, 0);
+        else if (p->nextUserNmi) p->nextUserNmi->process(ctx);
+        else ec_handle_trap(); // like without a user NMI handler
+      }
+      PluginPmuProfiler* p;
+    };
+
+    KernelNmi kernelNmi;
+    UserNmi userNmi;
+    IIrqHandler<cpu::KernelIRQFrame*>* nextKernelNmi = nullptr;
+    IIrqHandler<cpu::ThreadState*>* nextUserNmi = nullptr;
+    std::atomic<PmuSampleBuffer*> buffer = {nullptr};
+    uint32_t counter = 0;
+    bool enabled = false;
+  };
+
+  PluginPmuProfiler pluginPmuProfiler;
+
+} // namespace mythos
@@ -26,7 +26,7 @@
 #pragma once
 
 #include "async/IResult.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/CapEntry.hh"
 #include "objects/RevokeOperation.hh"
 #include "plugins/TestPlugin.hh"
@@ -54,7 +54,7 @@ class TestCaps : public TestPlugin, public IResult<void>
     void proto();
 
     Tasklet tasklet;
-    async::NestedMonitorDelegating monitor;
+    async::ObjectMonitor monitor;
     RevokeOperation op;
   };
 
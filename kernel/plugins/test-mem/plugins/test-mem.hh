@@ -26,7 +26,7 @@
 #pragma once
 
 #include "async/IResult.hh"
-#include "async/NestedMonitorDelegating.hh"
+#include "async/ObjectMonitor.hh"
 #include "objects/CapEntry.hh"
 #include "objects/RevokeOperation.hh"
 #include "plugins/TestPlugin.hh"
@@ -53,7 +53,7 @@ class TestMem : public TestPlugin, public IResult<void>
     void proto();
 
     Tasklet tasklet;
-    async::NestedMonitorDelegating monitor;
+    async::ObjectMonitor monitor;
     RevokeOperation op;
 
     IPageMap* pml4map;
@@ -61,6 +61,7 @@ namespace mythos {
 	  case 1: ;
 	  }
 	  MLOG_INFO(mlog::boot, "TestPlaces: finished roundtrip");
+	  for (cpu::ThreadID id=0; id<cpu::getNumThreads(); id++) async::getPlace(id)->logStats();
 	  state = 2;
 	  return this->monitor.responseAndRequestDone();
 	default:
@@ -0,0 +1,97 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include "runtime/PortalBase.hh"
+#include "runtime/ISysretHandler.hh"
+#include "runtime/Tasklet.hh"
+#include "mythos/syscall.hh"
+
+namespace mythos {
+
+  /** Multiplexes outstanding invocations on several portals of the
+   * calling thread. Instead of blocking in wait() on each future, a
+   * continuation is attached with then() and run() dispatches the
+   * system call results until all continuations have run. Thus,
+   * independent kernel operations overlap and dependent ones are
+   * issued from the continuations.
+   *
+   * All portals must be owned by the calling execution context
+   * because their results arrive through its SYSCALL_WAIT events.
+   * The continuations run inside then() if the result was available
+   * already, otherwise inside run().
+   */
+  class EventLoop
+  {
+  public:
+    EventLoop() {}
+    EventLoop(EventLoop const&) = delete;
+
+    /** runs fun(result) when the future completed. The lock of the
+     * future moves to the continuation and is released before fun is
+     * called with a copy of the result. Thus, fun may issue the next
+     * invocation on the same portal and attach it with the same
+     * tasklet. The tasklet must stay valid until then. */
+    template<class T, class FUN>
+    void then(PortalFuture<T>& future, Tasklet& t, FUN const& fun) {
+      if (!future) { // not invoked, report like wait() would
+        fun(future.wait());
+        return;
+      }
+      pending++;
+      // the tasklet payload is never destroyed, hence it must not own the lock
+      auto portal = future.detach();
+      t << Continuation<T,FUN>(this, portal, fun);
+      portal->then(t);
+    }
+
+    /** dispatches system call results until no continuation is pending */
+    void run() {
+      while (pending > 0) ISysretHandler::handle(syscall_wait());
+    }
+
+    size_t getPending() const { return pending; }
+
+  protected:
+    template<class T, class FUN>
+    struct Continuation {
+      Continuation(EventLoop* loop, PortalBase* portal, FUN const& fun)
+        : loop(loop), portal(portal), fun(fun) {}
+      void operator() (Tasklet&) {
+        loop->pending--;
+        auto res = PortalFuture<T>(PortalLock::adopt(portal)).wait(); // returns immediately
+        // the portal is free again, fun may issue the next invocation on it
+        fun(std::move(res));
+      }
+      EventLoop* loop;
+      PortalBase* portal; //< the lock of the future until the continuation runs
+      FUN fun;
+    };
+
+    size_t pending = 0;
+  };
+
+} // namespace mythos
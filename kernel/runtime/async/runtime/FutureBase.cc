@@ -46,10 +46,10 @@ namespace mythos {
   }
 
   void FutureBase::signal() {
-    if (waiting) {
-      (*waiting)();
-      waiting = nullptr;
-    }
+    // cleared before the call, the waiter may attach the next one
+    auto w = waiting;
+    waiting = nullptr;
+    if (w) (*w)();
   }
 
 } // namespace mythos
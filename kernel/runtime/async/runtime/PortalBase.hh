@@ -98,6 +98,10 @@ namespace mythos {
     void release() { if (_portal) _portal->release(); _portal = nullptr; }
     bool isOpen() const { return _portal; }
 
+    /** hands the lock over to the caller, who has to pass it to adopt() later */
+    PortalBase* detach() { auto p = _portal; _portal = nullptr; return p; }
+    static PortalLock adopt(PortalBase* p) { PortalLock l; l._portal = p; return l; }
+
     bool operator! () const { return !isOpen(); }
     explicit operator bool() const { return isOpen(); }
 
@@ -0,0 +1,139 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include "runtime/PortalPool.hh"
+#include "runtime/PageMap.hh"
+#include "runtime/KernelMemory.hh"
+#include "runtime/CapAlloc.hh"
+#include "runtime/thread-extra.hh"
+#include "runtime/mlog.hh"
+#include "util/align.hh"
+
+extern mythos::Portal portal;
+extern mythos::PageMap myAS;
+extern mythos::KernelMemory kmem;
+
+namespace mythos {
+
+  PortalPool portalPool(portal);
+
+  static thread_local Portal* localPortal = nullptr; //< cached result of local()
+
+  optional<void> PortalPool::init(PortalLock& pl, uintptr_t vaddr)
+  {
+    typedef protocol::PageMap::MapFlags MapFlags;
+    ASSERT(is_aligned(vaddr, align4K));
+    Frame f(capAlloc());
+    auto res = f.create(pl, kmem, round_up(FRAME_SIZE, align4K), align4K).wait();
+    if (!res) RETHROW(res);
+    protocol::PageMap::MmapMany batch(kmem.cap(), MapFlags().writable(true).configurable(true));
+    std::array<CapPtr, 3> t = {{capAlloc(), capAlloc(), capAlloc()}};
+    for (auto c : t) batch.addTable(c);
+    batch.add(f.cap(), vaddr, round_up(FRAME_SIZE, align4K), MapFlags().writable(true));
+    auto res2 = myAS.mmapMany(pl, batch).wait();
+    if (!res2) {
+      capAlloc.free(f, pl);
+      for (auto c : t) capAlloc.free(c, pl);
+      RETHROW(res2);
+    }
+    Mutex::Lock guard(m);
+    frame = f;
+    tables = t;
+    this->vaddr = vaddr;
+    MLOG_DETAIL(mlog::app, "portal pool", DVARhex(vaddr), DVAR(MAX_PORTALS), DVAR(res2->tables));
+    RETURN(Error::SUCCESS);
+  }
+
+  Portal& PortalPool::local()
+  {
+    if (localPortal) return *localPortal;
+    // the portal is assigned before the thread starts and does not change afterwards
+    localPortal = &shared;
+    auto ec = mythos_get_pthread_ec_self();
+    if (ec == init::EC) return shared; // the main thread keeps the initial portal
+    for (auto& slot : slots) {
+      if (slot.owner.load(std::memory_order_acquire) == ec) {
+        localPortal = slot.portal;
+        break;
+      }
+    }
+    return *localPortal;
+  }
+
+  Portal* PortalPool::assign(PortalLock& pl, CapPtr ec)
+  {
+    Mutex::Lock guard(m);
+    if (!vaddr) return nullptr;
+    Slot* slot = nullptr;
+    for (size_t i = 0; i < created; i++) {
+      if (slots[i].owner.load() == null_cap) { slot = &slots[i]; break; }
+    }
+    if (!slot && created < MAX_PORTALS) {
+      auto idx = created;
+      auto p = new Portal(capAlloc(), reinterpret_cast<void*>(vaddr + idx*sizeof(InvocationBuf)));
+      auto res = p->create(pl, kmem).wait();
+      if (!res) {
+        MLOG_WARN(mlog::app, "portal pool: create failed", DVAR(res.state()));
+        capAlloc.freeEmpty(p->cap());
+        delete p;
+        return nullptr;
+      }
+      auto res2 = p->bind(pl, frame, idx*sizeof(InvocationBuf), null_cap).wait();
+      if (!res2) {
+        MLOG_WARN(mlog::app, "portal pool: bind failed", DVAR(res2.state()));
+        capAlloc.free(*p, pl);
+        delete p;
+        return nullptr;
+      }
+      slot = &slots[idx];
+      slot->portal = p;
+      created++;
+    }
+    if (!slot) return nullptr; // exhausted
+    // rebind the owner, the invocation buffer stays the same
+    auto res = slot->portal->bind(pl, Frame(null_cap), 0, ec).wait();
+    if (!res) return nullptr;
+    slot->owner.store(ec, std::memory_order_release);
+    return slot->portal;
+  }
+
+  void PortalPool::release(PortalLock& pl, CapPtr ec)
+  {
+    for (auto& slot : slots) {
+      if (slot.portal && slot.owner.load() == ec) return release(pl, *slot.portal);
+    }
+  }
+
+  void PortalPool::release(PortalLock& pl, Portal& p)
+  {
+    auto res = p.bind(pl, Frame(null_cap), 0, delete_cap).wait();
+    if (!res) MLOG_WARN(mlog::app, "portal pool: unbind failed", DVAR(res.state()));
+    for (auto& slot : slots) {
+      if (slot.portal == &p) slot.owner.store(null_cap, std::memory_order_release);
+    }
+  }
+
+} // namespace mythos
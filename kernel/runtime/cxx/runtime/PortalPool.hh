@@ -0,0 +1,98 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include "runtime/Portal.hh"
+#include "runtime/Frame.hh"
+#include "runtime/Mutex.hh"
+#include "util/optional.hh"
+
+namespace mythos {
+
+  /** Portals for the application's threads, each with its own
+   * invocation buffer, so that threads do not serialize on the
+   * initial portal. The main thread keeps the initial portal.
+   *
+   * A thread that creates another thread assigns a portal from the
+   * pool to the new execution context before it starts. The new
+   * thread finds its portal on first use. The thread that joins it
+   * returns the portal to the pool before the execution context is
+   * deleted. The portal stays bound to the invocation buffer and only
+   * its owner changes.
+   *
+   * The invocation buffers are carved from a single frame that is
+   * mapped by init(). Before that and when the pool is exhausted, the
+   * threads fall back to the initial portal.
+   */
+  class PortalPool
+  {
+  public:
+    static constexpr size_t MAX_PORTALS = 256;
+    static constexpr size_t FRAME_SIZE = MAX_PORTALS*sizeof(InvocationBuf);
+
+    PortalPool(Portal& shared) : shared(shared) {}
+
+    /** creates the frame for the invocation buffers and maps it at
+     * vaddr. The page maps for the range are created if they are
+     * missing and are kept by the pool. */
+    optional<void> init(PortalLock& pl, uintptr_t vaddr);
+
+    /** the portal of the calling thread. */
+    Portal& local();
+
+    /** binds a free portal to the execution context ec. Returns
+     * nullptr if the pool is not initialised or exhausted. A thread may
+     * assign additional portals to itself in order to have several
+     * invocations in flight, see EventLoop. */
+    Portal* assign(PortalLock& pl, CapPtr ec);
+
+    /** unbinds the portal of the execution context ec and returns it
+     * to the pool. Called by another thread before ec is deleted. */
+    void release(PortalLock& pl, CapPtr ec);
+
+    /** unbinds the portal p and returns it to the pool. */
+    void release(PortalLock& pl, Portal& p);
+
+  private:
+    struct Slot {
+      Portal* portal = nullptr;
+      std::atomic<CapPtr> owner = {null_cap}; //< null_cap if free
+    };
+
+    Portal& shared;
+    Frame frame;
+    std::array<CapPtr, 3> tables = {{null_cap, null_cap, null_cap}}; //< page maps for the frame
+    uintptr_t vaddr = 0;
+    size_t created = 0;
+    Slot slots[MAX_PORTALS];
+    Mutex m;
+  };
+
+  extern PortalPool portalPool;
+
+} // namespace mythos
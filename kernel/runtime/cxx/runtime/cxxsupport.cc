@@ -43,7 +43,7 @@
 #include "util/elf64.hh"
 #include "runtime/ExecutionContext.hh"
 #include "runtime/Portal.hh"
-#include "runtime/ExecutionContext.hh"
+#include "runtime/PortalPool.hh"
 #include "runtime/CapMap.hh"
 #include "runtime/Example.hh"
 #include "runtime/PageMap.hh"
@@ -120,6 +120,7 @@ extern "C" [[noreturn]] void __assert_fail (const char *expr, const char *file,
 
 void mythosExit(){
     MLOG_ERROR(mlog::app, "MYTHOS:PLEASE KILL ME!!!!!!1 elf");
+    mlog::sink->flush();
 }
 
 struct iovec
@@ -147,10 +148,49 @@ int prlimit(
     return 0;
 }
 
+// hardware thread the calling thread was pinned to, or -1 if it may run anywhere
+static thread_local int pinnedThread = -1;
+
+// preferred hardware thread for the next thread that the calling thread creates, or -1
+static thread_local int cloneThread = -1;
+
+extern "C" void mythos_set_clone_thread(int thread)
+{
+    cloneThread = thread;
+}
+
 int sched_setaffinity(pid_t pid, size_t cpusetsize, cpu_set_t *mask)
 {
     //MLOG_DETAIL(mlog::app, "syscall sched_setaffinity", DVAR(pid), DVAR(cpusetsize), DVARhex(mask));
-    if(cpusetsize == info_ptr->getNumThreads() && mask == NULL) return -EFAULT;
+    if (mask == NULL) return -EFAULT;
+    // the thread id is the capability of the thread's execution context
+    auto self = mythos_get_pthread_ec_self();
+    mythos::CapPtr target = pid ? mythos::CapPtr(pid) : self;
+
+    // an execution context runs on exactly one scheduling context, thus take the first cpu
+    size_t numThreads = info_ptr->getNumThreads();
+    size_t cpu = 0;
+    while (cpu < numThreads && !CPU_ISSET_S(cpu, cpusetsize, mask)) cpu++;
+    if (cpu == numThreads) return -EINVAL;
+
+    if (target == self && pinnedThread == int(cpu)) return 0;
+
+    mythos::PortalLock pl(mythos::portalPool.local());
+    // take the scheduling context from the processor allocator
+    auto sc = pa.alloc(pl, mythos::null_cap, uint32_t(cpu)).wait();
+    if (!sc) {
+        MLOG_WARN(mlog::app, "sched_setaffinity: allocation failed", DVAR(cpu), sc.state());
+        return -EINVAL;
+    }
+    if (sc->cap == mythos::null_cap) return -EBUSY; // the cpu is taken already
+    // the kernel moves the execution context even while it is running
+    mythos::ExecutionContext ec(target);
+    auto res = ec.configure(pl, mythos::PageMap(), mythos::CapMap(), sc->cap).wait();
+    if (!res) {
+        MLOG_WARN(mlog::app, "sched_setaffinity failed", DVAR(target), DVAR(cpu), res.state());
+        return -EINVAL;
+    }
+    if (target == self) pinnedThread = int(cpu);
     return 0;
 }
 
@@ -160,7 +200,10 @@ int sched_getaffinity(pid_t pid, size_t cpusetsize, cpu_set_t *mask)
     if (mask) {
         //CPU_ZERO(mask);
 	memset(mask, 0, cpusetsize);
-        for(int i = 0; i < info_ptr->getNumThreads(); i++) CPU_SET(i, mask);
+        // only the own pinning is known, other threads report all cpus
+        bool self = !pid || mythos::CapPtr(pid) == mythos_get_pthread_ec_self();
+        if (self && pinnedThread >= 0) CPU_SET_S(pinnedThread, cpusetsize, mask);
+        else for(int i = 0; i < info_ptr->getNumThreads(); i++) CPU_SET_S(i, cpusetsize, mask);
     }
     return info_ptr->getNumThreads();
 }
@@ -316,12 +359,15 @@ int myclone(
     // We will use the same trick for alignment as musl libc
     auto rsp = (uintptr_t(stack) & uintptr_t(-16))-8;
 
-    mythos::PortalLock pl(portal); // future access will fail if the portal is in use already
+    mythos::PortalLock pl(mythos::portalPool.local());
     mythos::ExecutionContext ec(capAlloc());
     if (ptid && (flags&CLONE_PARENT_SETTID)) *ptid = int(ec.cap());
     // @todo store thread-specific ctid pointer, which should set to 0 by the OS on the thread's exit
 
-    auto sc = pa.alloc(pl).wait();
+    // take the preferred hardware thread if it is still free, otherwise any
+    auto sc = (cloneThread < 0) ? pa.alloc(pl).wait()
+      : pa.alloc(pl, mythos::null_cap, uint32_t(cloneThread)).wait();
+    if (sc && sc->cap == mythos::null_cap && cloneThread >= 0) sc = pa.alloc(pl).wait();
     ASSERT(sc);
     if(sc->cap == mythos::null_cap){
       MLOG_WARN(mlog::app, "Processor allocation failed!");
@@ -335,10 +381,15 @@ int myclone(
       .sched(sc->cap)
       .rawStack(rsp)
       .rawFun(func, arg)
-      .suspended(false)
+      .suspended(true)
       .fs(tls)
       .invokeVia(pl)
       .wait();
+    // give the new thread its own portal before it starts
+    if (!mythos::portalPool.assign(pl, ec.cap())) {
+      MLOG_DETAIL(mlog::app, "no own portal for new thread", DVAR(ec.cap()));
+    }
+    ec.resume(pl).wait();
     //MLOG_DETAIL(mlog::app, DVAR(ec.cap()));
     return ec.cap();
 }
@@ -362,7 +413,8 @@ extern "C" void mythos_pthread_cleanup(pthread_t t){
     pthreadCleaner.wait(t);
     // delete EC of target pthread
     auto cap = mythos_get_pthread_ec(t);
-    mythos::PortalLock pl(portal); 
+    mythos::PortalLock pl(mythos::portalPool.local());
+    mythos::portalPool.release(pl, cap);
     capAlloc.free(cap, pl);
     // memory of target pthread will be free when returning from this function
 }
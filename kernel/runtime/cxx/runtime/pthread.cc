@@ -25,8 +25,16 @@
  */
 
 #include "runtime/mlog.hh"
+#include "runtime/futex.hh"
+#include "runtime/thread-extra.hh"
 
 #include <pthread.h>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+#include <errno.h>
 
 //#define use_pthreads_stubs
 
@@ -147,11 +155,6 @@ extern "C" int pthread_mutex_trylock(pthread_mutex_t *){
 }
 #endif
 
-extern "C" int pthread_mutex_timedlock(pthread_mutex_t *__restrict, const struct timespec *__restrict){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
-}
-
 #ifdef use_pthreads_stubs
 extern "C" int pthread_mutex_destroy(pthread_mutex_t *){
 	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
@@ -219,104 +222,315 @@ extern "C" int pthread_cond_signal(pthread_cond_t *){
 #endif
 
 
-extern "C" int pthread_rwlock_init(pthread_rwlock_t *__restrict, const pthread_rwlockattr_t *__restrict){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
+// The spinlocks, barriers and reader-writer locks are implemented here
+// instead of musl's in order to scale to many hardware threads: the
+// waiters spin a short while on words that are only written once per
+// hand-over and then block via the futex emulation, which suspends the
+// execution context with mythos_wait and wakes it with syscall_signal.
+
+static inline void cpu_relax() { asm volatile("pause" ::: "memory"); }
+
+/** number of polls before a waiter blocks on the futex. */
+static constexpr unsigned SPIN_LIMIT = 1000;
+
+/** blocks until the word differs from val. */
+static void blockWhileEqual(std::atomic<uint32_t>* word, uint32_t val)
+{
+	while (word->load(std::memory_order_acquire) == val) {
+		do_futex(reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, val, nullptr, nullptr, 0, 0);
+	}
 }
 
-extern "C" int pthread_rwlock_destroy(pthread_rwlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
+static void wakeAll(std::atomic<uint32_t>* word)
+{
+	do_futex(reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0, 0);
 }
 
-#ifdef use_pthreads_stubs
-extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
+
+/** Reader-writer lock with per-thread reader indicators.
+ *
+ * Readers only increment the indicator of their slot and check the
+ * writer word, thus concurrent readers on different slots do not share
+ * any cache line. A writer announces itself in the writer word and waits
+ * until all indicators drained. Readers that observe a writer step back,
+ * which gives writers preference. The indicator array is allocated on
+ * init or on first use of a statically initialised lock.
+ */
+struct alignas(64) RwLockSlot
+{
+	std::atomic<uint32_t> readers;
+};
+
+static constexpr unsigned RWLOCK_SLOTS = 64;
+
+struct RwLock
+{
+	enum : uint32_t { FREE = 0, LOCKED = 1, CONTENDED = 2 };
+	std::atomic<uint32_t> writer;
+	std::atomic<uint32_t> owner; //< execution context of the writer
+	std::atomic<RwLockSlot*> slots;
+};
+static_assert(sizeof(RwLock) <= sizeof(pthread_rwlock_t), "RwLock does not fit into pthread_rwlock_t");
+
+static RwLock* rwlock(pthread_rwlock_t* l) { return reinterpret_cast<RwLock*>(l); }
+
+static RwLockSlot* allocRwLockSlots()
+{
+	auto mem = aligned_alloc(alignof(RwLockSlot), RWLOCK_SLOTS*sizeof(RwLockSlot));
+	if (!mem) return nullptr;
+	auto slots = static_cast<RwLockSlot*>(mem);
+	for (unsigned i = 0; i < RWLOCK_SLOTS; i++) slots[i].readers.store(0);
+	return slots;
 }
-#endif
 
-#ifdef use_pthreads_stubs
-extern "C" int pthread_rwlock_tryrdlock(pthread_rwlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
+static RwLockSlot* rwlockSlots(RwLock* l)
+{
+	auto slots = l->slots.load(std::memory_order_acquire);
+	if (slots) return slots;
+	auto mine = allocRwLockSlots();
+	if (!mine) return nullptr;
+	if (l->slots.compare_exchange_strong(slots, mine)) return mine;
+	free(mine);
+	return slots;
+}
+
+/** the indicator slot of the calling thread, fixed for its lifetime. */
+static unsigned rwlockSlotIndex()
+{
+	static std::atomic<unsigned> next = {0};
+	static thread_local unsigned index = next.fetch_add(1) % RWLOCK_SLOTS;
+	return index;
+}
+
+static void rwlockReadRelease(RwLock* l, RwLockSlot& slot)
+{
+	// the last reader of a slot wakes a writer that waits for the drain
+	if (slot.readers.fetch_sub(1) == 1 && l->writer.load() != RwLock::FREE) wakeAll(&slot.readers);
+}
+
+static bool rwlockTryRead(RwLock* l, RwLockSlot& slot)
+{
+	slot.readers.fetch_add(1);
+	if (l->writer.load() == RwLock::FREE) return true;
+	rwlockReadRelease(l, slot);
+	return false;
+}
+
+static void rwlockWaitWriter(RwLock* l)
+{
+	for (unsigned i = 0; i < SPIN_LIMIT; i++) {
+		if (l->writer.load(std::memory_order_acquire) == RwLock::FREE) return;
+		cpu_relax();
+	}
+	uint32_t w = l->writer.load();
+	while (w != RwLock::FREE) {
+		if (w == RwLock::CONTENDED || l->writer.compare_exchange_weak(w, RwLock::CONTENDED)) {
+			do_futex(reinterpret_cast<uint32_t*>(&l->writer), FUTEX_WAIT, RwLock::CONTENDED, nullptr, nullptr, 0, 0);
+		}
+		w = l->writer.load();
+	}
 }
-#endif
 
-#ifdef use_pthreads_stubs
-extern "C" int pthread_rwlock_timedrdlock(pthread_rwlock_t *__restrict, const struct timespec *__restrict){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+static void rwlockWaitReaders(RwLockSlot* slots)
+{
+	for (unsigned i = 0; i < RWLOCK_SLOTS; i++) {
+		unsigned spin = 0;
+		uint32_t r;
+		while ((r = slots[i].readers.load()) != 0) {
+			if (spin++ < SPIN_LIMIT) cpu_relax();
+			else do_futex(reinterpret_cast<uint32_t*>(&slots[i].readers), FUTEX_WAIT, r, nullptr, nullptr, 0, 0);
+		}
+	}
+}
+
+extern "C" int pthread_rwlock_init(pthread_rwlock_t *__restrict l, const pthread_rwlockattr_t *__restrict){
+	auto slots = allocRwLockSlots();
+	if (!slots) return ENOMEM;
+	auto rw = rwlock(l);
+	rw->writer.store(RwLock::FREE);
+	rw->owner.store(mythos::null_cap);
+	rw->slots.store(slots);
+	return 0;
+}
+
+extern "C" int pthread_rwlock_destroy(pthread_rwlock_t *l){
+	free(rwlock(l)->slots.exchange(nullptr));
+	return 0;
+}
+
+extern "C" int pthread_rwlock_tryrdlock(pthread_rwlock_t *l){
+	auto rw = rwlock(l);
+	auto slots = rwlockSlots(rw);
+	if (!slots) return ENOMEM;
+	return rwlockTryRead(rw, slots[rwlockSlotIndex()]) ? 0 : EBUSY;
+}
+
+extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t *l){
+	auto rw = rwlock(l);
+	auto slots = rwlockSlots(rw);
+	if (!slots) return ENOMEM;
+	auto& slot = slots[rwlockSlotIndex()];
+	while (!rwlockTryRead(rw, slot)) rwlockWaitWriter(rw);
 	return 0;
 }
-#endif
 
-#ifdef use_pthreads_stubs
-extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
+/// @todo the futex emulation has no timeouts, thus the timed variants just block
+extern "C" int pthread_rwlock_timedrdlock(pthread_rwlock_t *__restrict l, const struct timespec *__restrict){
+	return pthread_rwlock_rdlock(l);
 }
-#endif
 
-#ifdef use_pthreads_stubs
-extern "C" int pthread_rwlock_trywrlock(pthread_rwlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+extern "C" int pthread_rwlock_trywrlock(pthread_rwlock_t *l){
+	auto rw = rwlock(l);
+	auto slots = rwlockSlots(rw);
+	if (!slots) return ENOMEM;
+	uint32_t expected = RwLock::FREE;
+	if (!rw->writer.compare_exchange_strong(expected, RwLock::LOCKED)) return EBUSY;
+	for (unsigned i = 0; i < RWLOCK_SLOTS; i++) {
+		if (slots[i].readers.load() != 0) {
+			if (rw->writer.exchange(RwLock::FREE) == RwLock::CONTENDED) wakeAll(&rw->writer);
+			return EBUSY;
+		}
+	}
+	rw->owner.store(mythos_get_pthread_ec_self());
 	return 0;
 }
-#endif
 
-#ifdef use_pthreads_stubs
-extern "C" int pthread_rwlock_timedwrlock(pthread_rwlock_t *__restrict, const struct timespec *__restrict){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t *l){
+	auto rw = rwlock(l);
+	auto slots = rwlockSlots(rw);
+	if (!slots) return ENOMEM;
+	// keep the contended state once we had to wait, the unlock has to wake the others
+	uint32_t next = RwLock::LOCKED;
+	while (true) {
+		uint32_t expected = RwLock::FREE;
+		if (rw->writer.compare_exchange_strong(expected, next)) break;
+		rwlockWaitWriter(rw);
+		next = RwLock::CONTENDED;
+	}
+	rwlockWaitReaders(slots);
+	rw->owner.store(mythos_get_pthread_ec_self());
 	return 0;
 }
-#endif
 
-#ifdef use_pthreads_stubs
-extern "C" int pthread_rwlock_unlock(pthread_rwlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+extern "C" int pthread_rwlock_timedwrlock(pthread_rwlock_t *__restrict l, const struct timespec *__restrict){
+	return pthread_rwlock_wrlock(l);
+}
+
+extern "C" int pthread_rwlock_unlock(pthread_rwlock_t *l){
+	auto rw = rwlock(l);
+	if (rw->owner.load() == mythos_get_pthread_ec_self()) {
+		rw->owner.store(mythos::null_cap);
+		if (rw->writer.exchange(RwLock::FREE) == RwLock::CONTENDED) wakeAll(&rw->writer);
+	} else {
+		rwlockReadRelease(rw, rw->slots.load()[rwlockSlotIndex()]);
+	}
 	return 0;
 }
-#endif
 
 
-extern "C" int pthread_spin_init(pthread_spinlock_t *, int){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+/** Ticket spinlock in the 32 bits of pthread_spinlock_t: the upper half
+ * holds the next ticket and the lower half the ticket being served.
+ * Waiters back off proportional to their distance to the head of the
+ * queue. A queue lock like MCS would need a node per acquisition, which
+ * the pthread_spin interface cannot pass along.
+ */
+static std::atomic<uint32_t>* spinlock(pthread_spinlock_t* l)
+{
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(pthread_spinlock_t),
+	              "ticket lock does not fit into pthread_spinlock_t");
+	return reinterpret_cast<std::atomic<uint32_t>*>(const_cast<int*>(l));
+}
+
+extern "C" int pthread_spin_init(pthread_spinlock_t *l, int){
+	spinlock(l)->store(0);
 	return 0;
 }
 
 extern "C" int pthread_spin_destroy(pthread_spinlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
 	return 0;
 }
 
-extern "C" int pthread_spin_lock(pthread_spinlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
+extern "C" int pthread_spin_lock(pthread_spinlock_t *l){
+	auto lock = spinlock(l);
+	uint16_t ticket = uint16_t(lock->fetch_add(1u << 16, std::memory_order_relaxed) >> 16);
+	while (true) {
+		uint16_t serving = uint16_t(lock->load(std::memory_order_acquire));
+		if (serving == ticket) return 0;
+		for (uint16_t d = uint16_t(ticket - serving); d > 0; d--) cpu_relax();
+	}
 }
 
-extern "C" int pthread_spin_trylock(pthread_spinlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
-	return 0;
+extern "C" int pthread_spin_trylock(pthread_spinlock_t *l){
+	auto lock = spinlock(l);
+	uint32_t w = lock->load(std::memory_order_relaxed);
+	if (uint16_t(w >> 16) != uint16_t(w)) return EBUSY;
+	return lock->compare_exchange_strong(w, w + (1u << 16), std::memory_order_acquire) ? 0 : EBUSY;
 }
 
-extern "C" int pthread_spin_unlock(pthread_spinlock_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+extern "C" int pthread_spin_unlock(pthread_spinlock_t *l){
+	auto lock = spinlock(l);
+	// only the owner changes the lower half, but increment without carrying into the tickets
+	uint32_t w = lock->load(std::memory_order_relaxed);
+	while (!lock->compare_exchange_weak(w, (w & 0xFFFF0000u) | uint16_t(w + 1), std::memory_order_release));
 	return 0;
 }
 
 
-extern "C" int pthread_barrier_init(pthread_barrier_t *__restrict, const pthread_barrierattr_t *__restrict, unsigned){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+/** Barrier that counts arrivals with one atomic increment and releases
+ * the waiters by advancing the episode on a separate cache line. The
+ * waiters spin on the episode and then block on it. The counters grow
+ * monotonically, thus the last arrival does not need to reset anything
+ * before the next episode can begin.
+ */
+struct Barrier
+{
+	alignas(64) std::atomic<uint64_t> arrived;
+	alignas(64) std::atomic<uint32_t> episode;
+	std::atomic<uint32_t> sleepers;
+	uint32_t count;
+};
+
+static Barrier*& barrier(pthread_barrier_t* b)
+{
+	static_assert(sizeof(Barrier*) <= sizeof(pthread_barrier_t), "pointer does not fit into pthread_barrier_t");
+	return *reinterpret_cast<Barrier**>(b);
+}
+
+extern "C" int pthread_barrier_init(pthread_barrier_t *__restrict b, const pthread_barrierattr_t *__restrict, unsigned count){
+	if (count == 0) return EINVAL;
+	auto mem = aligned_alloc(alignof(Barrier), sizeof(Barrier));
+	if (!mem) return ENOMEM;
+	auto bar = new(mem) Barrier;
+	bar->arrived.store(0);
+	bar->episode.store(0);
+	bar->sleepers.store(0);
+	bar->count = count;
+	barrier(b) = bar;
 	return 0;
 }
 
-extern "C" int pthread_barrier_destroy(pthread_barrier_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+extern "C" int pthread_barrier_destroy(pthread_barrier_t *b){
+	free(barrier(b));
+	barrier(b) = nullptr;
 	return 0;
 }
 
-extern "C" int pthread_barrier_wait(pthread_barrier_t *){
-	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
+extern "C" int pthread_barrier_wait(pthread_barrier_t *b){
+	auto bar = barrier(b);
+	auto ticket = bar->arrived.fetch_add(1);
+	uint32_t episode = uint32_t(ticket / bar->count);
+	if (ticket % bar->count == bar->count - 1) {
+		bar->episode.store(episode + 1);
+		if (bar->sleepers.load() != 0) wakeAll(&bar->episode);
+		return PTHREAD_BARRIER_SERIAL_THREAD;
+	}
+	for (unsigned i = 0; i < SPIN_LIMIT; i++) {
+		if (bar->episode.load(std::memory_order_acquire) != episode) return 0;
+		cpu_relax();
+	}
+	bar->sleepers.fetch_add(1);
+	blockWhileEqual(&bar->episode, episode);
+	bar->sleepers.fetch_sub(1);
 	return 0;
 }
 
@@ -627,15 +841,19 @@ extern "C" void _pthread_cleanup_pop(struct __ptcb *, int){
 
 
 #ifdef _GNU_SOURCE
+#ifdef use_pthreads_stubs
 extern "C" int pthread_getaffinity_np(pthread_t, size_t, struct cpu_set_t *){
 	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
 	return 0;
 }
+#endif
 
+#ifdef use_pthreads_stubs
 extern "C" int pthread_setaffinity_np(pthread_t, size_t, const struct cpu_set_t *){
 	MLOG_ERROR(mlog::app, __PRETTY_FUNCTION__);
 	return 0;
 }
+#endif
 
 #ifdef use_pthreads_stubs
 extern "C" int pthread_getattr_np(pthread_t, pthread_attr_t *){
@@ -160,6 +160,47 @@ namespace mythos {
       return pr.invoke<protocol::ExecutionContext::Suspend>(_cap);
     }
 
+    /** page faults are sent as KEvent to the pager, see protocol::ExecutionContext::SetPager. */
+    PortalFuture<void> setPager(PortalLock pr, CapPtr pager, KEvent::Context context) {
+      return pr.invoke<protocol::ExecutionContext::SetPager>(_cap, pager, context);
+    }
+
+    /** maps the frame into the page map and resumes the faulted EC. */
+    PortalFuture<PageMap::Result>
+    resolveFault(PortalLock pr, PageMap pm, Frame frame, uintptr_t vaddr, size_t size,
+                 PageMap::MapFlags flags, size_t offset=0) {
+      return pr.invoke<protocol::ExecutionContext::ResolveFault>(_cap, pm.cap(), frame.cap(),
+                                                                 vaddr, size, flags, offset);
+    }
+
+    /** eventSelect points to ConfigureCounters::NUM_PMCS selectors. */
+    PortalFuture<void> configureCounters(PortalLock pr, uint64_t const* eventSelect, bool fixed, bool userRead) {
+      return pr.invoke<protocol::ExecutionContext::ConfigureCounters>(_cap, eventSelect, fixed, userRead);
+    }
+
+    struct Counters {
+      Counters() {}
+      Counters(InvocationBuf* ib) {
+        auto msg = ib->cast<protocol::ExecutionContext::Counters>();
+        for (size_t i = 0; i < msg->NUM_PMCS; i++) pmc[i] = msg->pmc[i];
+        for (size_t i = 0; i < msg->NUM_FIXED; i++) fixed[i] = msg->fixed[i];
+      }
+      uint64_t pmc[protocol::ExecutionContext::Counters::NUM_PMCS] = {};
+      uint64_t fixed[protocol::ExecutionContext::Counters::NUM_FIXED] = {};
+    };
+
+    PortalFuture<Counters> readCounters(PortalLock pr) {
+      return pr.invoke<protocol::ExecutionContext::ReadCounters>(_cap);
+    }
+
+    /** reads a counter of the running EC directly, needs userRead.
+     * The fixed function counters start at index 1<<30. */
+    static uint64_t rdpmc(uint32_t counter) {
+      uint32_t lo, hi;
+      asm volatile("rdpmc" : "=a"(lo), "=d"(hi) : "c"(counter));
+      return (uint64_t(hi) << 32) | lo;
+    }
+
   };
 
 } // namespace mythos
@@ -52,6 +52,20 @@ namespace mythos {
     PortalFuture<void> unmaskIRQ(PortalLock pr, uint32_t interrupt) {
       return pr.invoke<protocol::InterruptControl::UnmaskIRQ>(_cap, interrupt);
     }
+
+    struct Pending {
+      Pending() {}
+      Pending(InvocationBuf* ib) {
+        count = ib->cast<protocol::InterruptControl::Pending>()->count;
+      }
+      uint32_t count = 0;
+    };
+
+    /** returns the number of interrupts since the last signal and
+     * re-arms the signal. */
+    PortalFuture<Pending> acknowledge(PortalLock pr, uint32_t interrupt) {
+      return pr.invoke<protocol::InterruptControl::Acknowledge>(_cap, interrupt);
+    }
   };
 
 } // namespace mythos
@@ -58,6 +58,17 @@ namespace mythos {
       size_t level = 0;
     };
 
+    struct ManyResult : public Result {
+      ManyResult() {}
+      ManyResult(InvocationBuf* ib) : Result(ib) {
+        auto msg = ib->cast<protocol::PageMap::MmapManyResult>();
+        mapped = msg->mapped;
+        tables = msg->tables;
+      }
+      uint32_t mapped = 0; //< number of completely mapped entries
+      uint32_t tables = 0; //< number of page maps that were created
+    };
+
     PortalFuture<Result>
     installMap(PortalLock pr, PageMap pagemap, uintptr_t vaddr, size_t level, MapFlags flags) {
       return pr.invoke<protocol::PageMap::InstallMap>(_cap, pagemap.cap(), vaddr, level, flags);
@@ -73,6 +84,12 @@ namespace mythos {
       return pr.invoke<protocol::PageMap::Mmap>(_cap, frame.cap(), vaddr, size, flags, offset);
     }
 
+    /** maps all entries of the batch in one invocation, see protocol::PageMap::MmapMany. */
+    PortalFuture<ManyResult>
+    mmapMany(PortalLock pr, protocol::PageMap::MmapMany const& batch) {
+      return std::move(pr.invokeWithMsg(_cap, batch));
+    }
+
     PortalFuture<Result>
     remap(PortalLock pr, uintptr_t sourceAddr, uintptr_t destAddr, size_t size) {
       return pr.invoke<protocol::PageMap::Remap>(_cap, sourceAddr, destAddr, size);
@@ -87,6 +104,11 @@ namespace mythos {
     munmap(PortalLock pr, uintptr_t vaddr, size_t size) {
       return pr.invoke<protocol::PageMap::Munmap>(_cap, vaddr, size);
     }
+
+    /** sets the frame that provides the private copies of copy_on_write mappings. */
+    PortalFuture<void> setCowPool(PortalLock pr, Frame pool) {
+      return pr.invoke<protocol::PageMap::SetCowPool>(_cap, pool.cap());
+    }
   };
 
 } // namespace mythos
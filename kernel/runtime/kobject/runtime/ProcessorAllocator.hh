@@ -56,6 +56,11 @@ namespace mythos {
       return pr.invoke<protocol::ProcessorAllocator::Alloc>(_cap, dstMap);
     }
 
+    /** allocates the scheduling context of a specific hardware thread. */
+    PortalFuture<AllocResult> alloc(PortalLock pr, CapPtr dstMap, uint32_t thread){
+      return pr.invoke<protocol::ProcessorAllocator::Alloc>(_cap, dstMap, thread);
+    }
+
     PortalFuture<void> free(PortalLock pr, CapPtr sc){
       return pr.invoke<protocol::ProcessorAllocator::Free>(_cap, sc);
     }
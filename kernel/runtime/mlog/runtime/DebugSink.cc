@@ -26,17 +26,39 @@
 
 #include "util/Logger.hh"
 #include "mythos/syscall.hh"
+#include "mythos/InfoFrame.hh"
+
+extern mythos::InfoFrame* info_ptr asm("info_ptr");
 
 namespace mlog {
 
+  /** appends the output to the process' log ring, which the kernel
+   * drains to its own sink. Falls back to one debug system call per
+   * message as long as there is no info frame. */
   class DebugSink
     : public ISink
   {
   public:
     virtual ~DebugSink() {}
-    virtual void write(char const* str, size_t len) { mythos::syscall_debug(str, len); }
+
+    virtual void write(char const* str, size_t len) {
+      if (!info_ptr) { mythos::syscall_debug(str, len); return; }
+      auto ring = info_ptr->getLogRing();
+      while (len > 0) {
+        auto taken = ring->push(str, len);
+        if (taken == 0) { mythos::syscall_debug_ring(ring); continue; } // full
+        str += taken;
+        len -= taken;
+      }
+      if (ring->needsDrain(__builtin_ia32_rdtsc())) mythos::syscall_debug_ring(ring);
+    }
+
     virtual void writeTrace(char const* str, size_t len) { write(str,len); };
-    virtual void flush() {}
+
+    virtual void flush() {
+      if (info_ptr && info_ptr->getLogRing()->fill() != 0)
+        mythos::syscall_debug_ring(info_ptr->getLogRing());
+    }
   };
 
   static DebugSink debugSink;
@@ -0,0 +1,373 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+#include "runtime/OmpTeam.hh"
+#include "runtime/mlog.hh"
+#include "runtime/thread-extra.hh"
+#include "mythos/syscall.hh"
+#include "mythos/InfoFrame.hh"
+#include "util/assert.hh"
+#include <cstdlib>
+#include <sched.h>
+
+extern mythos::InfoFrame* info_ptr asm("info_ptr");
+
+namespace mythos {
+namespace omp {
+
+  Team team;
+
+  ThreadState& self()
+  {
+    static thread_local ThreadState state;
+    return state;
+  }
+
+  void ThreadState::enter(TeamThread* member, unsigned tid, unsigned size)
+  {
+    this->member = member;
+    this->tid = tid;
+    this->size = size;
+    level++;
+    if (size > 1) activeLevel++;
+    nextSize = 0;
+    task = nullptr;
+    group = nullptr;
+    loops = 0;
+    singles = 0;
+    dispatch = nullptr;
+  }
+
+  static inline void pause() { asm volatile("pause" ::: "memory"); }
+
+  static void invoke(microtask_t fn, int32_t gtid, int32_t tid, int argc, void** a)
+  {
+    switch (argc) {
+    case 0: fn(&gtid, &tid); break;
+    case 1: fn(&gtid, &tid, a[0]); break;
+    case 2: fn(&gtid, &tid, a[0], a[1]); break;
+    case 3: fn(&gtid, &tid, a[0], a[1], a[2]); break;
+    case 4: fn(&gtid, &tid, a[0], a[1], a[2], a[3]); break;
+    case 5: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4]); break;
+    case 6: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5]); break;
+    case 7: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6]); break;
+    case 8: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]); break;
+    case 9: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8]); break;
+    case 10: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9]); break;
+    case 11: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10]); break;
+    case 12: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10], a[11]); break;
+    case 13: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10], a[11], a[12]); break;
+    case 14: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10], a[11], a[12], a[13]); break;
+    case 15: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10], a[11], a[12], a[13], a[14]); break;
+    case 16: fn(&gtid, &tid, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10], a[11], a[12], a[13], a[14], a[15]); break;
+    default:
+      MLOG_ERROR(mlog::app, "too many arguments for the parallel region", DVAR(argc));
+      PANIC_MSG(false, "parallel region with more than 16 arguments");
+    }
+  }
+
+  bool TaskDeque::push(TaskHeader* t)
+  {
+    auto b = bottom.load(std::memory_order_relaxed);
+    auto tp = top.load(std::memory_order_acquire);
+    if (b - tp >= SIZE) return false;
+    buffer[b % SIZE].store(t, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  TaskHeader* TaskDeque::take()
+  {
+    auto b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top.load(std::memory_order_relaxed);
+    if (t > b) { // empty
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    auto task = buffer[b % SIZE].load(std::memory_order_relaxed);
+    if (t == b) { // the last one, race against the thieves
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) task = nullptr;
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  TaskHeader* TaskDeque::steal()
+  {
+    auto t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+    auto task = buffer[t % SIZE].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) return nullptr;
+    return task;
+  }
+
+  unsigned Team::maxThreads() const
+  {
+    auto n = info_ptr->getNumThreads();
+    return n < MAX_THREADS ? unsigned(n) : MAX_THREADS;
+  }
+
+  bool Team::spawn(unsigned count)
+  {
+    // place the workers compactly on the hardware threads after the
+    // master's one. The kernel numbers them in the firmware's order, which
+    // keeps the threads of a core and of a package next to each other.
+    auto n = unsigned(info_ptr->getNumThreads());
+    unsigned base = 0;
+    cpu_set_t mask;
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+      while (base < n && !CPU_ISSET(base, &mask)) base++;
+      if (base == n) base = 0;
+    }
+    bool ok = true;
+    while (ok && numThreads < count) {
+      auto& t = threads[numThreads];
+      t.index = numThreads;
+      t.seen = generation.load();
+      // the processor allocator hands out the scheduling context once,
+      // an occupied hardware thread falls back to any free one
+      mythos_set_clone_thread(int((base + numThreads) % n));
+      if (pthread_create(&t.pthread, nullptr, &workerMain, &t) != 0) {
+        MLOG_WARN(mlog::app, "OpenMP team limited by the available hardware threads", DVAR(numThreads));
+        ok = false;
+      } else numThreads++;
+    }
+    mythos_set_clone_thread(-1);
+    return ok;
+  }
+
+  void* Team::workerMain(void* arg)
+  {
+    auto& t = *static_cast<TeamThread*>(arg);
+    t.ec = mythos_get_pthread_ec_self();
+    team.work(t);
+    return nullptr;
+  }
+
+  void Team::wake(TeamThread& t)
+  {
+    if (t.sleeping.load()) syscall_signal(t.ec);
+  }
+
+  template<class COND>
+  void Team::waitUntil(ThreadState& ts, TeamThread& self, COND cond, bool help)
+  {
+    for (unsigned i = 0; !cond(); i++) {
+      if (help && runTask(ts)) { i = 0; continue; }
+      if (i < SPIN_LIMIT) { pause(); continue; }
+      // the waker checks the flag after changing the condition
+      self.sleeping.store(true);
+      if (!cond()) mythos_wait();
+      self.sleeping.store(false);
+    }
+  }
+
+  void Team::work(TeamThread& self)
+  {
+    auto& ts = omp::self();
+    while (true) {
+      waitUntil(ts, self, [&]{ return generation.load() != self.seen; }, false);
+      self.seen = generation.load();
+      if (self.index >= size) continue; // not needed in this region
+      SavedRegion saved(ts);
+      ts.enter(&self, self.index, size);
+      invoke(fn, int32_t(self.index), int32_t(self.index), argc, args);
+      barrier(ts);
+    }
+  }
+
+  void Team::serialized(ThreadState& ts, microtask_t fn, int argc, void** args)
+  {
+    SavedRegion saved(ts);
+    ts.enter(nullptr, 0, 1);
+    invoke(fn, 0, 0, argc, args);
+    // tasks of serialized regions are executed immediately
+  }
+
+  void Team::fork(ThreadState& ts, unsigned request, microtask_t fn, int argc, void** args)
+  {
+    // nested regions and regions of other threads while the team is busy run serialized
+    bool expected = false;
+    if (ts.level > 0 || request == 1 || !busy.compare_exchange_strong(expected, true)) {
+      serialized(ts, fn, argc, args);
+      return;
+    }
+    if (request == 0 || request > MAX_THREADS) request = maxThreads();
+    spawn(request);
+
+    this->size = request < numThreads ? request : numThreads;
+    this->fn = fn;
+    this->argc = argc;
+    this->args = args;
+    singleCount.store(0);
+    for (unsigned i = 0; i < DISPATCH_BUFFERS; i++) {
+      dispatchBuffers[i].index.store(i);
+      dispatchBuffers[i].next.store(0);
+      dispatchBuffers[i].done.store(0);
+    }
+    auto& master = threads[0];
+    master.pthread = pthread_self();
+    master.ec = mythos_get_pthread_ec_self();
+
+    {
+      SavedRegion saved(ts);
+      ts.enter(&master, 0, size);
+      generation.fetch_add(1);
+      for (unsigned i = 1; i < size; i++) wake(threads[i]);
+      invoke(fn, 0, 0, argc, args);
+      barrier(ts); // the join
+    }
+    busy.store(false);
+  }
+
+  void Team::barrier(ThreadState& ts)
+  {
+    if (ts.member == nullptr || ts.size == 1) return;
+    auto ep = episode.load();
+    if (arrived.fetch_add(1) + 1 == ts.size) {
+      // the last one waits for the outstanding tasks and helps with them
+      while (pendingTasks.load() != 0) if (!runTask(ts)) pause();
+      arrived.store(0);
+      episode.store(ep + 1);
+      for (unsigned i = 0; i < ts.size; i++) if (i != ts.tid) wake(threads[i]);
+    } else {
+      waitUntil(ts, *ts.member, [&]{ return episode.load() != ep; }, true);
+    }
+  }
+
+  void Team::account(TaskHeader* t)
+  {
+    t->parentChildren->fetch_add(1);
+    if (t->group) t->group->pending.fetch_add(1);
+    pendingTasks.fetch_add(1);
+  }
+
+  void Team::pushTask(ThreadState& ts, TaskHeader* t)
+  {
+    account(t);
+    // serialized regions and full queues execute the task immediately
+    if (ts.member == nullptr || ts.size == 1 || !ts.member->deque.push(t)) execute(ts, t);
+  }
+
+  bool Team::runTask(ThreadState& ts)
+  {
+    if (ts.member == nullptr) return false;
+    auto t = ts.member->deque.take();
+    for (unsigned i = 1; t == nullptr && i < ts.size; i++) {
+      t = threads[(ts.tid + i) % ts.size].deque.steal();
+    }
+    if (t == nullptr) return false;
+    execute(ts, t);
+    return true;
+  }
+
+  void Team::execute(ThreadState& ts, TaskHeader* t)
+  {
+    auto task = ts.task;
+    auto group = ts.group;
+    ts.task = t;
+    ts.group = t->group;
+    t->task()->routine(int32_t(ts.tid), t->task());
+    ts.task = task;
+    ts.group = group;
+    complete(t);
+  }
+
+  void Team::beginUndeferred(ThreadState& ts, TaskHeader* t)
+  {
+    account(t);
+    t->undeferredParent = ts.task;
+    ts.task = t;
+  }
+
+  void Team::completeUndeferred(ThreadState& ts, TaskHeader* t)
+  {
+    ts.task = t->undeferredParent;
+    complete(t);
+  }
+
+  void Team::complete(TaskHeader* t)
+  {
+    auto parent = t->parent;
+    auto group = t->group;
+    t->parentChildren->fetch_sub(1);
+    if (group) group->pending.fetch_sub(1);
+    pendingTasks.fetch_sub(1);
+    if (parent) release(parent);
+    release(t);
+  }
+
+  void Team::release(TaskHeader* t)
+  {
+    if (t->refs.fetch_sub(1) == 1) free(t);
+  }
+
+  void Team::taskwait(ThreadState& ts)
+  {
+    auto& children = ts.task ? ts.task->children : ts.implicitChildren;
+    while (children.load() != 0) if (!runTask(ts)) pause();
+  }
+
+  void Team::taskgroupWait(ThreadState& ts, TaskGroup* g)
+  {
+    while (g->pending.load() != 0) if (!runTask(ts)) pause();
+  }
+
+  DispatchBuffer& Team::dispatch(ThreadState& ts, uint32_t loop)
+  {
+    auto& buf = dispatchBuffers[loop % DISPATCH_BUFFERS];
+    // wait until the team members drained the loop that used this buffer before
+    while (buf.index.load(std::memory_order_acquire) != loop) pause();
+    return buf;
+  }
+
+  bool Team::single(ThreadState& ts)
+  {
+    if (ts.member == nullptr || ts.size == 1) return true;
+    // the first thread that reaches its n-th single construct advances the counter to n
+    uint32_t mine = ++ts.singles;
+    uint32_t expected = mine - 1;
+    return singleCount.compare_exchange_strong(expected, mine);
+  }
+
+  void Team::copyprivate(ThreadState& ts, void* data, void (*copy)(void*, void*), bool didit)
+  {
+    if (ts.member == nullptr || ts.size == 1) return;
+    if (didit) copyData = data;
+    barrier(ts);
+    if (!didit) copy(data, copyData);
+    barrier(ts);
+  }
+
+} // namespace omp
+} // namespace mythos
@@ -0,0 +1,228 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+#pragma once
+
+#include "mythos/caps.hh"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <pthread.h>
+
+namespace mythos {
+namespace omp {
+
+  typedef void (*microtask_t)(int32_t* gtid, int32_t* btid, ...);
+
+  /** Prefix of the compiler's kmp_task_t, followed by the private data. */
+  struct KmpTask
+  {
+    void* shareds;
+    int32_t (*routine)(int32_t gtid, void* task);
+    int32_t part_id;
+  };
+
+  /** Counts the unfinished tasks of a taskgroup including descendants. */
+  struct TaskGroup
+  {
+    std::atomic<uint32_t> pending = {0};
+    TaskGroup* parent = nullptr;
+  };
+
+  /** Runtime data in front of each explicit task. The header is freed
+   * when the task completed and none of its children needs it anymore.
+   */
+  struct alignas(16) TaskHeader
+  {
+    TaskHeader* parent; //< null for children of the implicit task
+    std::atomic<uint32_t>* parentChildren;
+    TaskGroup* group;
+    TaskHeader* undeferredParent; //< restored by __kmpc_omp_task_complete_if0
+    std::atomic<uint32_t> children; //< not completed child tasks for taskwait
+    std::atomic<uint32_t> refs; //< the task itself plus not completed children
+    KmpTask* task() { return reinterpret_cast<KmpTask*>(this+1); }
+    static TaskHeader* of(void* task) { return static_cast<TaskHeader*>(task)-1; }
+  };
+
+  /** Chase-Lev work-stealing deque with a fixed capacity. The owner
+   * pushes and takes at the bottom, all other threads steal from the top.
+   */
+  class TaskDeque
+  {
+  public:
+    static constexpr int64_t SIZE = 256;
+    bool push(TaskHeader* t);
+    TaskHeader* take();
+    TaskHeader* steal();
+  private:
+    alignas(64) std::atomic<int64_t> top = {0};
+    alignas(64) std::atomic<int64_t> bottom = {0};
+    std::atomic<TaskHeader*> buffer[SIZE];
+  };
+
+  /** Per hardware thread member of the hot team. */
+  struct alignas(64) TeamThread
+  {
+    pthread_t pthread;
+    CapPtr ec = null_cap;
+    std::atomic<bool> sleeping = {false};
+    unsigned index = 0;
+    uint64_t seen = 0; //< the last generation this worker took part in
+    TaskDeque deque;
+  };
+
+  /** Shared iteration counter of a dynamically scheduled loop. It serves
+   * loop number index and is handed to the loop index+DISPATCH_BUFFERS
+   * once all team members drained it.
+   */
+  struct alignas(64) DispatchBuffer
+  {
+    std::atomic<uint32_t> index;
+    std::atomic<uint64_t> next;
+    std::atomic<uint32_t> done;
+  };
+
+  /** The state of the calling thread within the OpenMP runtime. */
+  struct ThreadState
+  {
+    TeamThread* member = nullptr; //< null outside of the hot team
+    unsigned tid = 0;
+    unsigned size = 1;
+    unsigned level = 0;
+    unsigned activeLevel = 0;
+    unsigned nextSize = 0; //< requested by num_threads, 0 for default
+    TaskHeader* task = nullptr; //< the explicit task being executed
+    TaskGroup* group = nullptr;
+    std::atomic<uint32_t> implicitChildren = {0}; //< child tasks of the implicit task
+    uint32_t loops = 0; //< dynamically scheduled loops in the current region
+    uint32_t singles = 0; //< single constructs in the current region
+
+    // the dynamically scheduled loop of this thread, bounds in the loop's type
+    DispatchBuffer* dispatch = nullptr;
+    uint64_t serialNext = 0;
+    uint64_t lb = 0;
+    int64_t st = 1;
+    uint64_t trip = 0;
+    uint64_t chunk = 1;
+
+    void enter(TeamThread* member, unsigned tid, unsigned size);
+  };
+
+  ThreadState& self();
+
+  /** Restores the region of the calling thread when leaving a parallel region. */
+  struct SavedRegion
+  {
+    SavedRegion(ThreadState& ts)
+      : ts(ts), member(ts.member), tid(ts.tid), size(ts.size), level(ts.level)
+      , activeLevel(ts.activeLevel), task(ts.task), group(ts.group)
+      , loops(ts.loops), singles(ts.singles)
+    {}
+    ~SavedRegion() {
+      ts.member = member; ts.tid = tid; ts.size = size; ts.level = level;
+      ts.activeLevel = activeLevel; ts.task = task; ts.group = group;
+      ts.loops = loops; ts.singles = singles; ts.nextSize = 0;
+    }
+    ThreadState& ts;
+    TeamThread* member;
+    unsigned tid, size, level, activeLevel;
+    TaskHeader* task;
+    TaskGroup* group;
+    uint32_t loops, singles;
+  };
+
+  /** The persistent team of worker threads.
+   *
+   * The workers are created on the first parallel region that needs
+   * them, placed on the hardware threads following the master's one, and
+   * then stay bound to the scheduling context they got from the processor
+   * allocator. Between regions they spin on the generation
+   * counter and then suspend with mythos_wait. A fork publishes the
+   * region, increments the generation and signals only the workers that
+   * went to sleep. The join is the implicit barrier at the end of the
+   * region, which also drains the task queues.
+   */
+  class Team
+  {
+  public:
+    static constexpr unsigned MAX_THREADS = 256;
+    static constexpr unsigned DISPATCH_BUFFERS = 8;
+    static constexpr unsigned SPIN_LIMIT = 10000;
+
+    void fork(ThreadState& ts, unsigned size, microtask_t fn, int argc, void** args);
+    void barrier(ThreadState& ts);
+    unsigned maxThreads() const;
+
+    /// tasks
+    void pushTask(ThreadState& ts, TaskHeader* t);
+    void beginUndeferred(ThreadState& ts, TaskHeader* t);
+    void completeUndeferred(ThreadState& ts, TaskHeader* t);
+    bool runTask(ThreadState& ts);
+    void execute(ThreadState& ts, TaskHeader* t);
+    void complete(TaskHeader* t);
+    void taskwait(ThreadState& ts);
+    void taskgroupWait(ThreadState& ts, TaskGroup* g);
+    static void release(TaskHeader* t);
+
+    /// worksharing
+    DispatchBuffer& dispatch(ThreadState& ts, uint32_t loop);
+    bool single(ThreadState& ts);
+    void copyprivate(ThreadState& ts, void* data, void (*copy)(void*, void*), bool didit);
+
+    static void serialized(ThreadState& ts, microtask_t fn, int argc, void** args);
+
+  protected:
+    static void* workerMain(void* arg);
+    void work(TeamThread& self);
+    bool spawn(unsigned count);
+    void wake(TeamThread& t);
+    void account(TaskHeader* t);
+    template<class COND>
+    void waitUntil(ThreadState& ts, TeamThread& self, COND cond, bool help);
+
+  protected:
+    std::atomic<bool> busy = {false};
+    unsigned numThreads = 1; //< including the master
+    TeamThread threads[MAX_THREADS];
+
+    // the current region
+    microtask_t fn = nullptr;
+    int argc = 0;
+    void** args = nullptr;
+    unsigned size = 1;
+    alignas(64) std::atomic<uint64_t> generation = {0};
+
+    alignas(64) std::atomic<unsigned> arrived = {0};
+    alignas(64) std::atomic<uint64_t> episode = {0};
+    alignas(64) std::atomic<uint32_t> pendingTasks = {0};
+    alignas(64) std::atomic<uint32_t> singleCount = {0};
+    void* copyData = nullptr;
+    DispatchBuffer dispatchBuffers[DISPATCH_BUFFERS];
+  };
+
+  extern Team team;
+
+} // namespace omp
+} // namespace mythos
@@ -0,0 +1,553 @@
+/* -*- mode:C++; -*- */
+/* MIT License -- MyThOS: The Many-Threads Operating System
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright 2021 Randolf Rotta, Robert Kuban, and contributors, BTU Cottbus-Senftenberg
+ */
+
+// The entry points of LLVM's OpenMP runtime interface that clang emits,
+// mapped to the hot team in OmpTeam.cc. Ordered loops, cancellation,
+// teams and task dependences beyond serial execution are not supported.
+
+#include "runtime/OmpTeam.hh"
+#include "runtime/mlog.hh"
+#include "mythos/InfoFrame.hh"
+#include "util/assert.hh"
+#include <omp.h>
+#include <pthread.h>
+#include <cstdarg>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+extern mythos::InfoFrame* info_ptr asm("info_ptr");
+
+using namespace mythos::omp;
+
+struct ident_t;
+typedef int32_t kmp_critical_name[8];
+
+static std::atomic<int> numThreadsVar = {0}; //< set by omp_set_num_threads, 0 for all
+
+enum Schedule : int32_t {
+  SCH_STATIC_CHUNKED = 33,
+  SCH_STATIC = 34,
+  SCH_DYNAMIC_CHUNKED = 35,
+  SCH_GUIDED_CHUNKED = 36,
+  SCH_DISTRIBUTE_STATIC_CHUNKED = 91,
+  SCH_MODIFIER_MASK = (1<<29) | (1<<30)
+};
+
+static pthread_spinlock_t* spinlock(kmp_critical_name* crit)
+{
+  static_assert(sizeof(kmp_critical_name) >= sizeof(pthread_spinlock_t), "critical name too small");
+  return reinterpret_cast<pthread_spinlock_t*>(crit);
+}
+
+/* parallel regions */
+
+extern "C" void __kmpc_begin(ident_t*, int32_t) {}
+extern "C" void __kmpc_end(ident_t*) {}
+extern "C" int32_t __kmpc_ok_to_fork(ident_t*) { return 1; }
+
+extern "C" int32_t __kmpc_global_thread_num(ident_t*)
+{
+  auto& ts = self();
+  return ts.member ? int32_t(ts.member->index) : 0;
+}
+
+extern "C" int32_t __kmpc_global_num_threads(ident_t*) { return team.maxThreads(); }
+extern "C" int32_t __kmpc_bound_thread_num(ident_t*) { return self().tid; }
+extern "C" int32_t __kmpc_bound_num_threads(ident_t*) { return self().size; }
+extern "C" int32_t __kmpc_in_parallel(ident_t*) { return self().activeLevel > 0; }
+
+extern "C" void __kmpc_push_num_threads(ident_t*, int32_t, int32_t num_threads)
+{
+  self().nextSize = num_threads > 0 ? unsigned(num_threads) : 0;
+}
+
+extern "C" void __kmpc_push_proc_bind(ident_t*, int32_t, int) {}
+
+extern "C" void __kmpc_fork_call(ident_t*, int32_t argc, microtask_t fn, ...)
+{
+  void* args[16];
+  // the outlined function is called through a switch in Team::invoke
+  if (argc > 16) MLOG_ERROR(mlog::app, "too many arguments for the parallel region", DVAR(argc));
+  PANIC_MSG(argc <= 16, "parallel region with more than 16 arguments");
+  va_list ap;
+  va_start(ap, fn);
+  for (int32_t i = 0; i < argc; i++) args[i] = va_arg(ap, void*);
+  va_end(ap);
+  auto& ts = self();
+  unsigned size = ts.nextSize ? ts.nextSize : unsigned(numThreadsVar.load());
+  team.fork(ts, size, fn, argc, args);
+}
+
+/** regions with if(0) call the outlined function directly between these two. */
+struct SerializedFrame
+{
+  SerializedFrame(ThreadState& ts, SerializedFrame* prev) : saved(ts), prev(prev) {}
+  SavedRegion saved;
+  SerializedFrame* prev;
+};
+static thread_local SerializedFrame* serializedFrames = nullptr;
+
+extern "C" void __kmpc_serialized_parallel(ident_t*, int32_t)
+{
+  auto& ts = self();
+  serializedFrames = new SerializedFrame(ts, serializedFrames);
+  ts.enter(nullptr, 0, 1);
+}
+
+extern "C" void __kmpc_end_serialized_parallel(ident_t*, int32_t)
+{
+  auto frame = serializedFrames;
+  ASSERT(frame != nullptr);
+  serializedFrames = frame->prev;
+  delete frame;
+}
+
+/* synchronisation */
+
+extern "C" void __kmpc_barrier(ident_t*, int32_t) { team.barrier(self()); }
+extern "C" int32_t __kmpc_cancel_barrier(ident_t*, int32_t) { team.barrier(self()); return 0; }
+extern "C" void __kmpc_flush(ident_t*) { std::atomic_thread_fence(std::memory_order_seq_cst); }
+
+extern "C" int32_t __kmpc_master(ident_t*, int32_t) { return self().tid == 0; }
+extern "C" void __kmpc_end_master(ident_t*, int32_t) {}
+extern "C" int32_t __kmpc_masked(ident_t*, int32_t, int32_t filter) { return int32_t(self().tid) == filter; }
+extern "C" void __kmpc_end_masked(ident_t*, int32_t) {}
+
+extern "C" int32_t __kmpc_single(ident_t*, int32_t) { return team.single(self()); }
+extern "C" void __kmpc_end_single(ident_t*, int32_t) {}
+
+extern "C" void __kmpc_copyprivate(ident_t*, int32_t, size_t, void* data,
+                                   void (*copy)(void*, void*), int32_t didit)
+{
+  team.copyprivate(self(), data, copy, didit);
+}
+
+extern "C" void __kmpc_critical(ident_t*, int32_t, kmp_critical_name* crit)
+{
+  pthread_spin_lock(spinlock(crit));
+}
+
+extern "C" void __kmpc_critical_with_hint(ident_t*, int32_t, kmp_critical_name* crit, uint32_t)
+{
+  pthread_spin_lock(spinlock(crit));
+}
+
+extern "C" void __kmpc_end_critical(ident_t*, int32_t, kmp_critical_name* crit)
+{
+  pthread_spin_unlock(spinlock(crit));
+}
+
+/** Reductions always use the critical section method: each thread gets 1
+ * and combines its private copy into the shared variable under the lock.
+ */
+extern "C" int32_t __kmpc_reduce_nowait(ident_t*, int32_t, int32_t, size_t, void*,
+                                        void (*)(void*, void*), kmp_critical_name* lck)
+{
+  if (self().size > 1) pthread_spin_lock(spinlock(lck));
+  return 1;
+}
+
+extern "C" void __kmpc_end_reduce_nowait(ident_t*, int32_t, kmp_critical_name* lck)
+{
+  if (self().size > 1) pthread_spin_unlock(spinlock(lck));
+}
+
+extern "C" int32_t __kmpc_reduce(ident_t* loc, int32_t gtid, int32_t num_vars, size_t size, void* data,
+                                 void (*func)(void*, void*), kmp_critical_name* lck)
+{
+  return __kmpc_reduce_nowait(loc, gtid, num_vars, size, data, func, lck);
+}
+
+extern "C" void __kmpc_end_reduce(ident_t* loc, int32_t gtid, kmp_critical_name* lck)
+{
+  __kmpc_end_reduce_nowait(loc, gtid, lck);
+  team.barrier(self());
+}
+
+/* worksharing loops */
+
+template<class T, class ST>
+static void forStaticInit(int32_t schedule, int32_t* plast, T* plower, T* pupper, ST* pstride,
+                          ST incr, ST chunk)
+{
+  typedef typename std::make_unsigned<T>::type UT;
+  auto& ts = self();
+  UT tid = ts.tid;
+  UT nth = ts.size;
+  if (plast) *plast = 0;
+  if (incr > 0 ? *pupper < *plower : *pupper > *plower) { *pstride = incr; return; }
+  UT trip = (incr > 0) ? (UT(*pupper) - UT(*plower)) / UT(incr) + 1
+                       : (UT(*plower) - UT(*pupper)) / UT(-incr) + 1;
+
+  if (nth == 1) {
+    if (plast) *plast = 1;
+    *pstride = ST(trip) * incr;
+    return;
+  }
+
+  schedule &= ~SCH_MODIFIER_MASK;
+  if (schedule == SCH_STATIC_CHUNKED || schedule == SCH_DISTRIBUTE_STATIC_CHUNKED) {
+    // round robin chunks, the caller advances by the stride
+    if (chunk < 1) chunk = 1;
+    ST span = chunk * incr;
+    *pstride = span * ST(nth);
+    *plower = T(UT(*plower) + UT(span) * tid);
+    *pupper = T(UT(*plower) + UT(span) - UT(incr));
+    if (plast) *plast = (tid == ((trip - 1) / UT(chunk)) % nth);
+  } else {
+    // one balanced block per thread
+    if (trip < nth) {
+      if (tid < trip) *pupper = *plower = T(UT(*plower) + tid * UT(incr));
+      else *plower = T(UT(*pupper) + UT(incr));
+      if (plast) *plast = (tid == trip - 1);
+    } else {
+      UT small = trip / nth;
+      UT extras = trip % nth;
+      *plower = T(UT(*plower) + UT(incr) * (tid * small + (tid < extras ? tid : extras)));
+      *pupper = T(UT(*plower) + UT(incr) * (small - (tid < extras ? 0 : 1)));
+      if (plast) *plast = (tid == nth - 1);
+    }
+    *pstride = ST(trip) * incr;
+  }
+}
+
+extern "C" void __kmpc_for_static_init_4(ident_t*, int32_t, int32_t schedule, int32_t* plast,
+    int32_t* plower, int32_t* pupper, int32_t* pstride, int32_t incr, int32_t chunk)
+{
+  forStaticInit(schedule, plast, plower, pupper, pstride, incr, chunk);
+}
+
+extern "C" void __kmpc_for_static_init_4u(ident_t*, int32_t, int32_t schedule, int32_t* plast,
+    uint32_t* plower, uint32_t* pupper, int32_t* pstride, int32_t incr, int32_t chunk)
+{
+  forStaticInit(schedule, plast, plower, pupper, pstride, incr, chunk);
+}
+
+extern "C" void __kmpc_for_static_init_8(ident_t*, int32_t, int32_t schedule, int32_t* plast,
+    int64_t* plower, int64_t* pupper, int64_t* pstride, int64_t incr, int64_t chunk)
+{
+  forStaticInit(schedule, plast, plower, pupper, pstride, incr, chunk);
+}
+
+extern "C" void __kmpc_for_static_init_8u(ident_t*, int32_t, int32_t schedule, int32_t* plast,
+    uint64_t* plower, uint64_t* pupper, int64_t* pstride, int64_t incr, int64_t chunk)
+{
+  forStaticInit(schedule, plast, plower, pupper, pstride, incr, chunk);
+}
+
+extern "C" void __kmpc_for_static_fini(ident_t*, int32_t) {}
+
+/** Dynamic and guided loops hand out chunks from a shared counter, the
+ * static kinds get one chunk per thread. Guided is treated as dynamic.
+ */
+template<class T, class ST>
+static void dispatchInit(int32_t schedule, T lb, T ub, ST st, ST chunk)
+{
+  typedef typename std::make_unsigned<T>::type UT;
+  auto& ts = self();
+  UT trip = 0;
+  if (st > 0 && ub >= lb) trip = (UT(ub) - UT(lb)) / UT(st) + 1;
+  if (st < 0 && ub <= lb) trip = (UT(lb) - UT(ub)) / UT(-st) + 1;
+  schedule &= ~SCH_MODIFIER_MASK;
+  if (schedule == SCH_STATIC || (schedule == SCH_STATIC_CHUNKED && chunk < 1)) {
+    chunk = ST((trip + ts.size - 1) / ts.size);
+  }
+  if (chunk < 1) chunk = 1;
+  ts.lb = uint64_t(UT(lb));
+  ts.st = st;
+  ts.trip = trip;
+  ts.chunk = uint64_t(chunk);
+  ts.serialNext = 0;
+  ts.dispatch = (ts.member && ts.size > 1) ? &team.dispatch(ts, ts.loops++) : nullptr;
+}
+
+template<class T, class ST>
+static int32_t dispatchNext(int32_t* plast, T* plower, T* pupper, ST* pstride)
+{
+  typedef typename std::make_unsigned<T>::type UT;
+  auto& ts = self();
+  uint64_t c = ts.dispatch ? ts.dispatch->next.fetch_add(1) : ts.serialNext++;
+  uint64_t first = c * ts.chunk;
+  if (first >= ts.trip) {
+    // the last thread that drained the loop passes the buffer on
+    auto buf = ts.dispatch;
+    if (buf && buf->done.fetch_add(1) + 1 == ts.size) {
+      buf->next.store(0);
+      buf->done.store(0);
+      buf->index.store(buf->index.load() + Team::DISPATCH_BUFFERS, std::memory_order_release);
+    }
+    ts.dispatch = nullptr;
+    return 0;
+  }
+  uint64_t last = first + ts.chunk - 1;
+  if (last >= ts.trip) last = ts.trip - 1;
+  *plower = T(UT(ts.lb) + UT(first) * UT(ts.st));
+  *pupper = T(UT(ts.lb) + UT(last) * UT(ts.st));
+  if (pstride) *pstride = ST(ts.st);
+  if (plast) *plast = (last == ts.trip - 1);
+  return 1;
+}
+
+extern "C" void __kmpc_dispatch_init_4(ident_t*, int32_t, int32_t schedule,
+    int32_t lb, int32_t ub, int32_t st, int32_t chunk)
+{
+  dispatchInit(schedule, lb, ub, st, chunk);
+}
+
+extern "C" void __kmpc_dispatch_init_4u(ident_t*, int32_t, int32_t schedule,
+    uint32_t lb, uint32_t ub, int32_t st, int32_t chunk)
+{
+  dispatchInit(schedule, lb, ub, st, chunk);
+}
+
+extern "C" void __kmpc_dispatch_init_8(ident_t*, int32_t, int32_t schedule,
+    int64_t lb, int64_t ub, int64_t st, int64_t chunk)
+{
+  dispatchInit(schedule, lb, ub, st, chunk);
+}
+
+extern "C" void __kmpc_dispatch_init_8u(ident_t*, int32_t, int32_t schedule,
+    uint64_t lb, uint64_t ub, int64_t st, int64_t chunk)
+{
+  dispatchInit(schedule, lb, ub, st, chunk);
+}
+
+extern "C" int32_t __kmpc_dispatch_next_4(ident_t*, int32_t, int32_t* plast,
+    int32_t* plower, int32_t* pupper, int32_t* pstride)
+{
+  return dispatchNext(plast, plower, pupper, pstride);
+}
+
+extern "C" int32_t __kmpc_dispatch_next_4u(ident_t*, int32_t, int32_t* plast,
+    uint32_t* plower, uint32_t* pupper, int32_t* pstride)
+{
+  return dispatchNext(plast, plower, pupper, pstride);
+}
+
+extern "C" int32_t __kmpc_dispatch_next_8(ident_t*, int32_t, int32_t* plast,
+    int64_t* plower, int64_t* pupper, int64_t* pstride)
+{
+  return dispatchNext(plast, plower, pupper, pstride);
+}
+
+extern "C" int32_t __kmpc_dispatch_next_8u(ident_t*, int32_t, int32_t* plast,
+    uint64_t* plower, uint64_t* pupper, int64_t* pstride)
+{
+  return dispatchNext(plast, plower, pupper, pstride);
+}
+
+extern "C" void __kmpc_dispatch_fini_4(ident_t*, int32_t) {}
+extern "C" void __kmpc_dispatch_fini_4u(ident_t*, int32_t) {}
+extern "C" void __kmpc_dispatch_fini_8(ident_t*, int32_t) {}
+extern "C" void __kmpc_dispatch_fini_8u(ident_t*, int32_t) {}
+
+/* tasks */
+
+extern "C" KmpTask* __kmpc_omp_task_alloc(ident_t*, int32_t, int32_t, size_t sizeof_task,
+    size_t sizeof_shareds, int32_t (*entry)(int32_t, void*))
+{
+  auto& ts = self();
+  size_t taskSize = (sizeof_task + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  auto mem = malloc(sizeof(TaskHeader) + taskSize + sizeof_shareds);
+  if (!mem) return nullptr;
+  auto t = new(mem) TaskHeader;
+  t->parent = ts.task;
+  if (ts.task) ts.task->refs.fetch_add(1);
+  t->parentChildren = ts.task ? &ts.task->children : &ts.implicitChildren;
+  t->group = ts.group;
+  t->undeferredParent = nullptr;
+  t->children.store(0);
+  t->refs.store(1);
+  auto task = t->task();
+  task->shareds = sizeof_shareds ? reinterpret_cast<char*>(task) + taskSize : nullptr;
+  task->routine = entry;
+  task->part_id = 0;
+  return task;
+}
+
+extern "C" int32_t __kmpc_omp_task(ident_t*, int32_t, KmpTask* task)
+{
+  team.pushTask(self(), TaskHeader::of(task));
+  return 0;
+}
+
+extern "C" void __kmpc_omp_task_begin_if0(ident_t*, int32_t, KmpTask* task)
+{
+  team.beginUndeferred(self(), TaskHeader::of(task));
+}
+
+extern "C" void __kmpc_omp_task_complete_if0(ident_t*, int32_t, KmpTask* task)
+{
+  team.completeUndeferred(self(), TaskHeader::of(task));
+}
+
+/** Tasks with dependences run undeferred, which satisfies any dependence
+ * between sibling tasks because they are created in program order.
+ */
+extern "C" int32_t __kmpc_omp_task_with_deps(ident_t*, int32_t gtid, KmpTask* task,
+    int32_t, void*, int32_t, void*)
+{
+  auto& ts = self();
+  auto t = TaskHeader::of(task);
+  team.beginUndeferred(ts, t);
+  task->routine(gtid, task);
+  team.completeUndeferred(ts, t);
+  return 0;
+}
+
+extern "C" void __kmpc_omp_wait_deps(ident_t*, int32_t, int32_t, void*, int32_t, void*) {}
+
+extern "C" int32_t __kmpc_omp_taskwait(ident_t*, int32_t)
+{
+  team.taskwait(self());
+  return 0;
+}
+
+extern "C" int32_t __kmpc_omp_taskyield(ident_t*, int32_t, int)
+{
+  team.runTask(self());
+  return 0;
+}
+
+extern "C" void __kmpc_taskgroup(ident_t*, int32_t)
+{
+  auto& ts = self();
+  auto g = new TaskGroup;
+  g->parent = ts.group;
+  ts.group = g;
+}
+
+extern "C" void __kmpc_end_taskgroup(ident_t*, int32_t)
+{
+  auto& ts = self();
+  auto g = ts.group;
+  ASSERT(g != nullptr);
+  team.taskgroupWait(ts, g);
+  ts.group = g->parent;
+  delete g;
+}
+
+/* user API */
+
+extern "C" int omp_get_thread_num() { return self().tid; }
+extern "C" int omp_get_num_threads() { return self().size; }
+extern "C" int omp_get_num_procs() { return int(info_ptr->getNumThreads()); }
+extern "C" int omp_in_parallel() { return self().activeLevel > 0; }
+extern "C" int omp_get_level() { return self().level; }
+extern "C" int omp_get_active_level() { return self().activeLevel; }
+extern "C" void omp_set_dynamic(int) {}
+extern "C" int omp_get_dynamic() { return 0; }
+extern "C" void omp_set_nested(int) {}
+extern "C" int omp_get_nested() { return 0; }
+
+extern "C" void omp_set_num_threads(int n) { numThreadsVar.store(n > 0 ? n : 0); }
+
+extern "C" int omp_get_max_threads()
+{
+  int n = numThreadsVar.load();
+  return n ? n : int(team.maxThreads());
+}
+
+extern "C" double omp_get_wtime()
+{
+  unsigned low, high;
+  asm volatile("rdtsc" : "=a" (low), "=d" (high));
+  uint64_t tsc = low | uint64_t(high) << 32;
+  return double(tsc) * double(info_ptr->getPsPerTSC()) * 1e-12;
+}
+
+extern "C" double omp_get_wtick() { return double(info_ptr->getPsPerTSC()) * 1e-12; }
+
+static pthread_spinlock_t* spinlock(omp_lock_t* lock)
+{
+  static_assert(sizeof(omp_lock_t) >= sizeof(pthread_spinlock_t), "omp_lock_t too small");
+  return reinterpret_cast<pthread_spinlock_t*>(lock);
+}
+
+extern "C" void omp_init_lock(omp_lock_t* lock) { pthread_spin_init(spinlock(lock), 0); }
+extern "C" void omp_destroy_lock(omp_lock_t* lock) { pthread_spin_destroy(spinlock(lock)); }
+extern "C" void omp_set_lock(omp_lock_t* lock) { pthread_spin_lock(spinlock(lock)); }
+extern "C" void omp_unset_lock(omp_lock_t* lock) { pthread_spin_unlock(spinlock(lock)); }
+extern "C" int omp_test_lock(omp_lock_t* lock) { return pthread_spin_trylock(spinlock(lock)) == 0; }
+
+/** nestable locks do not fit into omp_nest_lock_t and live on the heap. */
+struct NestLock
+{
+  pthread_spinlock_t lock;
+  std::atomic<pthread_t> owner;
+  int count;
+};
+
+static NestLock*& nestlock(omp_nest_lock_t* lock)
+{
+  static_assert(sizeof(omp_nest_lock_t) >= sizeof(NestLock*), "omp_nest_lock_t too small");
+  return *reinterpret_cast<NestLock**>(lock);
+}
+
+extern "C" void omp_init_nest_lock(omp_nest_lock_t* lock)
+{
+  auto l = new NestLock;
+  pthread_spin_init(&l->lock, 0);
+  l->owner.store(pthread_t());
+  l->count = 0;
+  nestlock(lock) = l;
+}
+
+extern "C" void omp_destroy_nest_lock(omp_nest_lock_t* lock)
+{
+  delete nestlock(lock);
+  nestlock(lock) = nullptr;
+}
+
+extern "C" int omp_test_nest_lock(omp_nest_lock_t* lock)
+{
+  auto l = nestlock(lock);
+  if (l->owner.load() != pthread_self()) {
+    if (pthread_spin_trylock(&l->lock) != 0) return 0;
+    l->owner.store(pthread_self());
+  }
+  return ++l->count;
+}
+
+extern "C" void omp_set_nest_lock(omp_nest_lock_t* lock)
+{
+  auto l = nestlock(lock);
+  if (l->owner.load() != pthread_self()) {
+    pthread_spin_lock(&l->lock);
+    l->owner.store(pthread_self());
+  }
+  l->count++;
+}
+
+extern "C" void omp_unset_nest_lock(omp_nest_lock_t* lock)
+{
+  auto l = nestlock(lock);
+  if (--l->count == 0) {
+    l->owner.store(pthread_t());
+    pthread_spin_unlock(&l->lock);
+  }
+}
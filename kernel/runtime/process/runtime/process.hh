@@ -9,6 +9,10 @@
 #include "util/align.hh"
 #include "mythos/InfoFrame.hh"
 #include "runtime/CapAlloc.hh"
+#include "runtime/EventLoop.hh"
+#include "runtime/PortalPool.hh"
+#include "runtime/thread-extra.hh"
+#include <new>
 
 extern mythos::InfoFrame* info_ptr asm("info_ptr");
 extern mythos::CapMap myCS;
@@ -18,6 +22,109 @@ extern mythos::ProcessorAllocator pa;
 
 using namespace mythos;
 
+/** Prepares the parts of a process that all instances of an image can share.
+ *
+ * The read-only segments are mapped once into level 1 page maps. Each new
+ * process just installs these tables, non-configurable and read-only, instead
+ * of mapping every page again. Only 2MiB regions that contain no writable
+ * segment can be shared this way.
+ */
+class ProcessTemplate{
+  public:
+  enum { MAX_SHARED_TABLES = 8 };
+
+  ProcessTemplate(char* image, Frame imageFrame)
+    : img(image)
+    , imageFrame(imageFrame)
+  {}
+
+  static bool isSharedSegment(const elf64::PHeader* ph)
+  {
+      return !(ph->flags & elf64::PF_W) && ph->filesize == ph->memsize &&
+          is_aligned(ph->offset - ph->vaddr, align4K);
+  }
+
+  /** true if no segment that has to be copied touches the 2MiB region at vaddr. */
+  bool isSharedRegion(uintptr_t vaddr) const
+  {
+      for (size_t i=0; i <img.phnum(); ++i) {
+          auto ph = img.phdr(i);
+          if (ph->type != elf64::PT_LOAD || isSharedSegment(ph)) continue;
+          auto begin = round_down(ph->vaddr, align2M);
+          auto end = round_up(ph->vaddr + ph->memsize, align2M);
+          if (begin <= vaddr && vaddr < end) return false;
+      }
+      return true;
+  }
+
+  /** the shared level 1 page map for the 2MiB region at vaddr or nullptr. */
+  PageMap const* sharedTable(uintptr_t vaddr) const
+  {
+      for (size_t i=0; i < numTables; ++i) {
+          if (tables[i].vaddr == round_down(vaddr, align2M)) return &tables[i].table;
+      }
+      return nullptr;
+  }
+
+  optional<void> prepare(PortalLock& pl)
+  {
+      MLOG_DETAIL(mlog::app, "prepare process template ...");
+      ASSERT(img.isValid());
+      for (size_t i=0; i <img.phnum(); ++i) {
+          auto ph = img.phdr(i);
+          if (ph->type != elf64::PT_LOAD || !isSharedSegment(ph)) continue;
+          auto vbegin = round_down(ph->vaddr, align4K);
+          auto vend = round_up(ph->vaddr+ph->filesize, align4K);
+          for (auto region = round_down(vbegin, align2M); region < vend; region += align2M) {
+              if (!isSharedRegion(region)) continue;
+              if (!sharedTable(region)) {
+                  if (numTables == MAX_SHARED_TABLES) THROW(Error::INSUFFICIENT_RESOURCES);
+                  MLOG_DETAIL(mlog::app, "   create shared table", DVARhex(region));
+                  auto& entry = tables[numTables];
+                  entry.vaddr = region;
+                  entry.table = PageMap(capAlloc());
+                  auto res = entry.table.create(pl, kmem, 1).wait();
+                  if (!res) {
+                      capAlloc.freeEmpty(entry.table.cap());
+                      RETHROW(res);
+                  }
+                  numTables++;
+              }
+
+              // map the part of the segment that lies in this region
+              auto begin = region < vbegin ? vbegin : region;
+              auto end = region + align2M < vend ? region + align2M : vend;
+              protocol::PageMap::MapFlags mf = 0;
+              mf.executable = ph->flags&elf64::PF_X;
+              auto table = *sharedTable(region);
+              auto res = table.mmap(pl, imageFrame, begin - region, end - begin, mf,
+                  round_down(ph->offset, align4K) + (begin - vbegin)).wait();
+              if (!res) RETHROW(res);
+          }
+      }
+      RETURN(Error::SUCCESS);
+  }
+
+  /** deletes the shared tables. Processes that still use them lose
+   * the mappings of the read-only segments. */
+  void freeTables(PortalLock& pl)
+  {
+      for (size_t i=0; i < numTables; ++i) capAlloc.free(tables[i].table, pl);
+      numTables = 0;
+  }
+
+  elf64::Elf64Image img;
+  Frame imageFrame;
+
+  private:
+  struct SharedTable {
+    uintptr_t vaddr;
+    PageMap table;
+  };
+  SharedTable tables[MAX_SHARED_TABLES];
+  size_t numTables = 0;
+};
+
 class Process{
   public:
   Process(char* image)
@@ -25,6 +132,52 @@ class Process{
     , pCapAlloc(cs)
     , img(image)
   {}
+
+  /** Spawns an instance of a prepared template. */
+  Process(ProcessTemplate const& tmpl)
+    : cs(capAlloc())
+    , pCapAlloc(cs)
+    , img(tmpl.img)
+    , imageFrame(tmpl.imageFrame)
+    , tmpl(&tmpl)
+  {}
+
+  /** The image frame contains the ELF file at offset 0. Its read-only
+   * segments are mapped directly and, thus, shared between all processes
+   * that are launched from the same frame. */
+  Process(char* image, Frame imageFrame)
+    : cs(capAlloc())
+    , pCapAlloc(cs)
+    , img(image)
+    , imageFrame(imageFrame)
+  {}
+
+  bool isSharedSegment(const elf64::PHeader* ph) const
+  {
+      return imageFrame.cap() != null_cap && ProcessTemplate::isSharedSegment(ph);
+  }
+
+  optional<void> mapProgramHeader(PortalLock& pl, const elf64::PHeader* ph, PageMap& pm)
+  {
+      MLOG_DETAIL(mlog::app, "... map program header", DVAR(ph->type), DVAR(ph->flags), DVARhex(ph->offset),
+          DVARhex(ph->vaddr), DVARhex(ph->filesize), DVARhex(ph->memsize));
+      auto vbegin = round_down(ph->vaddr, align4K);
+      auto vend = round_up(ph->vaddr+ph->filesize, align4K);
+      if (vend-vbegin == 0) RETURN(Error::SUCCESS); // nothing to do
+
+      protocol::PageMap::MapFlags mf = 0;
+      mf.executable = ph->flags&elf64::PF_X;
+      // the 2MiB regions in the template's shared tables are mapped already
+      for (auto region = round_down(vbegin, align2M); region < vend; region += align2M) {
+          if (tmpl && tmpl->sharedTable(region)) continue;
+          auto begin = region < vbegin ? vbegin : region;
+          auto end = region + align2M < vend ? region + align2M : vend;
+          auto res = pm.mmap(pl, imageFrame, begin, end - begin, mf,
+              round_down(ph->offset, align4K) + (begin - vbegin)).wait();
+          if (!res) RETHROW(res);
+      }
+      RETURN(Error::SUCCESS);
+  }
   
   optional<void> loadProgramHeader(PortalLock& pl,
       const elf64::PHeader* ph, uintptr_t tmp_vaddr, Frame& f, size_t offset, PageMap& pm)
@@ -47,11 +200,14 @@ class Process{
       auto res = pm.mmap(pl, f, vbegin, vend-vbegin, mf, offset);
       TEST(res);
 
-      // zero the pages, then copy the data
-      MLOG_DETAIL(mlog::app, "    zeroing", DVARhex(tmp_vaddr + offset), DVARhex(vend-vbegin));
-      memset(reinterpret_cast<void*>(tmp_vaddr + offset), 0, vend-vbegin);
-      MLOG_DETAIL(mlog::app, "    copy data");
-      mythos::memcpy(reinterpret_cast<void*>(tmp_vaddr + offset + ph->vaddr - vbegin), img.getData(*ph), ph->filesize);
+      // copy the data and zero just the remaining parts of the pages
+      auto pstart = tmp_vaddr + offset;
+      auto head = ph->vaddr - vbegin;
+      auto tail = head + ph->filesize;
+      MLOG_DETAIL(mlog::app, "    copy data", DVARhex(pstart), DVARhex(vend-vbegin));
+      memset(reinterpret_cast<void*>(pstart), 0, head);
+      mythos::memcpy(reinterpret_cast<void*>(pstart + head), img.getData(*ph), ph->filesize);
+      memset(reinterpret_cast<void*>(pstart + tail), 0, vend-vbegin-tail);
       RETURN(Error::SUCCESS);
   }
 
@@ -61,14 +217,14 @@ class Process{
       ASSERT(img.isValid());
 
       uintptr_t ipc_addr = round_up(1u, align2M);
-      // 1) figure out how much bytes we need
+      // 1) figure out how much bytes we need for the segments that have to be copied
       size_t size = 0;
       for (size_t i=0; i <img.phnum(); ++i) {
           auto ph = img.phdr(i);
           if (ph->type == elf64::PT_LOAD) {
               auto begin = round_down(ph->vaddr, align2M);
               auto end = round_up(ph->vaddr + ph->memsize, align2M);
-              size += end-begin;
+              if (!isSharedSegment(ph)) size += end-begin;
               if (end >= ipc_addr) {
                 ipc_addr = round_up(end + 1u, align2M);
               }
@@ -76,19 +232,34 @@ class Process{
       }
       MLOG_DETAIL(mlog::app, "   bytes needed for loading image: ", DVARhex(size));
 
-      // 2) allocate a frame
+      // 2) map the read-only segments from the shared image frame
+      for (size_t i=0; i <img.phnum(); ++i) {
+          auto ph = img.phdr(i);
+          if (ph->type == elf64::PT_LOAD && isSharedSegment(ph)) {
+              auto res = mapProgramHeader(pl, ph, pm);
+              if (!res) RETHROW(res);
+          }
+      }
+      if (size == 0) return ipc_addr;
+
+      // 3) allocate a frame for the remaining segments
+      // They are copied eagerly. Mapping them copy-on-write from the image
+      // frame would need a copy-on-write pool for the new address space,
+      // and the partial last page and .bss still need zeroed pages.
       MLOG_DETAIL(mlog::app, "allocate frame for application image ...")
       Frame f(capAlloc());
-      auto res = f.create(pl, kmem, 2*size, align2M).wait();
+      auto res = f.create(pl, kmem, size, align2M).wait();
+      TEST(res);
+      imageCopy = f;
       
       uintptr_t tmp_vaddr = 42*align512G;
       MLOG_DETAIL(mlog::app, "temporary map frame to own address space ...", DVARhex(tmp_vaddr));
       MLOG_DETAIL(mlog::app, "   create PageMap");
       PageMap pm3(capAlloc());
-      res = pm3.create(pl, kmem, 3).wait();
-      TEST(res);
       PageMap pm2(capAlloc());
-      res = pm2.create(pl, kmem, 2).wait();
+      PageMap* tmpTables[] = {&pm3, &pm2};
+      size_t tmpLevels[] = {3, 2};
+      res = createMaps(pl, tmpTables, tmpLevels, 2);
       TEST(res);
 
       MLOG_DETAIL(mlog::app, "   installMap");
@@ -103,11 +274,11 @@ class Process{
       res = myAS.mmap(pl, f, tmp_vaddr, size, 0x1).wait();
       TEST(res);
 
-      // 3) process each program header: map to page, copy contents
+      // 4) process each remaining program header: map to page, copy contents
       size_t offset = 0;
       for (size_t i=0; i <img.phnum(); ++i) {
           auto ph = img.phdr(i);
-          if (ph->type == elf64::PT_LOAD) {
+          if (ph->type == elf64::PT_LOAD && !isSharedSegment(ph)) {
               auto begin = round_down(ph->vaddr, align2M);
               auto end = round_up(ph->vaddr + ph->memsize, align2M);
               auto res = loadProgramHeader(pl, ph, tmp_vaddr, f, offset, pm);
@@ -140,6 +311,70 @@ class Process{
       return ipc_addr;
   }
 
+  /** creates the page maps for the image below the new level 4 page
+   * map pm4 and loads the image. Returns the address for the info
+   * frame. The page maps and the frame for the copied segments belong
+   * to the process, see freeAddressSpace(). */
+  optional<uintptr_t> createAddressSpace(PortalLock& pl, PageMap& pm4)
+  {
+    //todo: use dynamic table allocation in mmap!
+    MLOG_DETAIL(mlog::app, "create PageMaps ...");
+    uintptr_t elf_vaddr = 0x400000;
+    typedef protocol::PageMap::MapFlags MapFlags;
+
+    // create tables, they do not depend on each other
+    PageMap* tables[3 + IMAGE_TABLES];
+    size_t levels[3 + IMAGE_TABLES];
+    size_t numTables = 0;
+    auto& pm3 = addMap();
+    auto& pm2 = addMap();
+    tables[numTables] = &pm4; levels[numTables++] = 4;
+    tables[numTables] = &pm3; levels[numTables++] = 3;
+    tables[numTables] = &pm2; levels[numTables++] = 2;
+    // the template's shared tables are read-only for this process
+    PageMap const* pm1[IMAGE_TABLES];
+    for (size_t i = 0; i < IMAGE_TABLES; i++) {
+      pm1[i] = tmpl ? tmpl->sharedTable(elf_vaddr + i*align2M) : nullptr;
+      if (pm1[i]) continue;
+      auto& pm = addMap();
+      pm1[i] = &pm;
+      tables[numTables] = &pm; levels[numTables++] = 1;
+    }
+    auto res = createMaps(pl, tables, levels, numTables);
+    if (!res) RETHROW(res);
+
+    // install tables
+    res = pm4.installMap(pl, pm3, ((elf_vaddr >> 39) & 0x1FF) << 39, 4,
+      MapFlags().writable(true).configurable(true)).wait();
+    if (!res) RETHROW(res);
+    res = pm3.installMap(pl, pm2, ((elf_vaddr >> 30) & 0x1FF) << 30, 3,
+      MapFlags().writable(true).configurable(true)).wait();
+    if (!res) RETHROW(res);
+
+    for (size_t i = 0; i < IMAGE_TABLES; i++) {
+      auto vaddr = elf_vaddr + i*align2M;
+      auto own = !(tmpl && tmpl->sharedTable(vaddr));
+      res = pm2.installMap(pl, *pm1[i], ((vaddr >> 21) & 0x1FF) << 21, 2,
+        MapFlags().writable(own).configurable(own)).wait();
+      if (!res) RETHROW(res);
+    }
+
+    return loadImage(pl, pm4);
+  }
+
+  /** deletes pm4 and the page maps and the frame of createAddressSpace(). */
+  void freeAddressSpace(PortalLock& pl, PageMap& pm4)
+  {
+    capAlloc.free(pm4, pl);
+    for (size_t i = 0; i < numMaps; i++) capAlloc.free(maps[i], pl);
+    numMaps = 0;
+    if (imageCopy.cap() != null_cap) capAlloc.free(imageCopy, pl);
+    imageCopy = Frame();
+  }
+
+  /** creates and starts the process. If it was constructed from a
+   * ProcessTemplate, createAddressSpace() installs the template's
+   * shared tables. Currently disabled, it returns before doing anything. */
   optional<CapPtr> createProcess(PortalLock& pl){
     MLOG_INFO(mlog::app, __func__);
     MLOG_ERROR(mlog::app, "process needs to be reworked!");
@@ -177,70 +412,9 @@ class Process{
       //TEST(res);
     //}
 
-    /* create address space */
-    //todo: use dynamic table allocation in mmap!
-    MLOG_DETAIL(mlog::app, "create PageMaps ...");
-    uintptr_t elf_vaddr = 0x400000;
-
-    // create tables
+    /* create address space and load image */
     PageMap pm4(capAlloc());
-    auto res_pm = pm4.create(pl, kmem, 4).wait();
-    TEST(res_pm);
-    PageMap pm3(capAlloc());
-    res_pm = pm3.create(pl, kmem, 3).wait();
-    TEST(res_pm);
-    PageMap pm2(capAlloc());
-    res_pm = pm2.create(pl, kmem, 2).wait();
-    TEST(res_pm);
-    PageMap pm10(capAlloc());
-    res_pm = pm10.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-    PageMap pm11(capAlloc());
-    res_pm = pm11.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-    PageMap pm12(capAlloc());
-    res_pm = pm12.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-    PageMap pm13(capAlloc());
-    res_pm = pm13.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-    PageMap pm14(capAlloc());
-    res_pm = pm14.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-    PageMap pm15(capAlloc());
-    res_pm = pm15.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-    PageMap pm16(capAlloc());
-    res_pm = pm16.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-    PageMap pm17(capAlloc());
-    res_pm = pm17.create(pl, kmem, 1).wait();
-    TEST(res_pm);
-
-    // install tables
-    pm4.installMap(pl, pm3, ((elf_vaddr >> 39) & 0x1FF) << 39, 4,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm3.installMap(pl, pm2, ((elf_vaddr >> 30) & 0x1FF) << 30, 3,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm10, ((elf_vaddr >> 21) & 0x1FF) << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm11, ((elf_vaddr >> 21) & 0x1FF) + 1 << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm12, ((elf_vaddr >> 21) & 0x1FF) + 2 << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm13, ((elf_vaddr >> 21) & 0x1FF) + 3 << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm14, ((elf_vaddr >> 21) & 0x1FF) + 4 << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm15, ((elf_vaddr >> 21) & 0x1FF) + 5 << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm16, ((elf_vaddr >> 21) & 0x1FF) + 6 << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-    pm2.installMap(pl, pm17, ((elf_vaddr >> 21) & 0x1FF) + 7 << 21, 2,
-      mythos::protocol::PageMap::MapFlags().writable(true).configurable(true)).wait();
-
-    /* load image */
-    auto ipc_vaddr = loadImage(pl, pm4);
+    auto ipc_vaddr = createAddressSpace(pl, pm4);
     TEST(ipc_vaddr);
 
     /* create InfoFrame */
@@ -275,7 +449,10 @@ class Process{
     TEST(res);
     
     MLOG_DETAIL(mlog::app, "   copy info frame content");
-    mythos::memcpy(reinterpret_cast<void*>(tmp_vaddr_if), info_ptr, sizeof(InfoFrame));
+    // the child gets an empty log ring instead of a copy of ours
+    auto childInfo = new(reinterpret_cast<void*>(tmp_vaddr_if)) InfoFrame();
+    childInfo->psPerTsc = info_ptr->psPerTsc;
+    childInfo->numThreads = info_ptr->numThreads;
 
     MLOG_DETAIL(mlog::app, "   unmap");
     res = myAS.munmap(pl, tmp_vaddr_if, size).wait();
@@ -395,10 +572,75 @@ class Process{
   }
 
   private:
+  enum { IMAGE_TABLES = 8, MAX_MAPS = 2 + IMAGE_TABLES, MAX_PORTALS = 4 };
+
+  /** creates the page maps tables[i] with the levels levels[i]. Up to
+   * MAX_PORTALS creations are in flight at once: besides pl, the
+   * calling thread gets additional portals from the portal pool. Each
+   * continuation issues the next creation on the portal that just
+   * completed, see EventLoop. Returns the first error. */
+  optional<void> createMaps(PortalLock& pl, PageMap* const* tables, size_t const* levels, size_t count)
+  {
+    struct Batch {
+      EventLoop loop;
+      Tasklet tasks[MAX_PORTALS];
+      PortalLock locks[MAX_PORTALS];
+      PageMap* const* tables;
+      size_t const* levels;
+      size_t count;
+      size_t next = 0;
+      Error error = Error::SUCCESS;
+
+      void issue(size_t slot) {
+        if (next == count || error != Error::SUCCESS) return;
+        auto i = next++;
+        auto res = tables[i]->create(locks[slot], kmem, levels[i]);
+        loop.then(res, tasks[slot], [this, slot](optional<void> r) {
+          if (!r && error == Error::SUCCESS) error = r.state();
+          issue(slot);
+        });
+      }
+    } batch;
+    batch.tables = tables;
+    batch.levels = levels;
+    batch.count = count;
+
+    Portal* portals[MAX_PORTALS] = {};
+    size_t numPortals = 1;
+    batch.locks[0] = PortalLock(pl); // shares the caller's lock
+    auto self = mythos_get_pthread_ec_self();
+    while (numPortals < MAX_PORTALS && numPortals < count) {
+      auto p = portalPool.assign(pl, self);
+      if (!p) break; // the pool is not initialised or exhausted, fewer in flight
+      portals[numPortals] = p;
+      batch.locks[numPortals++] = PortalLock(*p);
+    }
+
+    for (size_t slot = 0; slot < numPortals; slot++) batch.issue(slot);
+    batch.loop.run();
+
+    for (size_t slot = 1; slot < numPortals; slot++) {
+      batch.locks[slot].release();
+      portalPool.release(pl, *portals[slot]);
+    }
+    RETURN(batch.error);
+  }
+
+  PageMap& addMap() {
+    ASSERT(numMaps < MAX_MAPS);
+    maps[numMaps] = PageMap(capAlloc());
+    return maps[numMaps++];
+  }
+
   CapMap cs;
   SimpleCapAlloc<init::CAP_ALLOC_START
     , init::CAP_ALLOC_END - init::CAP_ALLOC_START> pCapAlloc;
   elf64::Elf64Image img;
+  Frame imageFrame;
+  ProcessTemplate const* tmpl = nullptr;
+  PageMap maps[MAX_MAPS]; //< page maps created by createAddressSpace()
+  size_t numMaps = 0;
+  Frame imageCopy; //< frame for the segments that are copied
 };
 
 
@@ -11,6 +11,11 @@
 // naming is designed to go well with pthread library calls
 
 
+/** The next thread that the calling thread creates is placed on the
+ * given hardware thread if it is still free, -1 lets the processor
+ * allocator choose. */
+extern "C" void mythos_set_clone_thread(int thread);
+
 inline void mythos_wait()
 {
   mythos::ISysretHandler::handle(mythos::syscall_wait());
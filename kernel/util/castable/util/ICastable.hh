@@ -26,6 +26,8 @@
 #pragma once
 
 #include "util/error-trace.hh"
+#include <atomic>
+#include <cstdint>
 
 namespace mythos {
 
@@ -61,17 +63,45 @@ namespace mythos {
 
     template<class T>
     optional<T*> cast() {
-      auto o = this->vcast(typeId<T>());
+      auto o = this->cachedCast(typeId<T>());
       if (o) return const_cast<T*>(reinterpret_cast<T const*>(*o));
       else RETHROW(o);
     }
 
     template<class T>
     optional<T const*> cast() const {
-      auto o = this->vcast(typeId<T>());
+      auto o = this->cachedCast(typeId<T>());
       if (o) return reinterpret_cast<T const*>(*o);
       RETHROW(o);
     }
+
+  protected:
+    /** The result of the first successful cast is remembered as the
+     * target type id together with the offset of the target from this,
+     * packed into one word: the type ids are kernel addresses, whose
+     * upper 16 bits are all set and can be dropped. Repeated casts to
+     * the same type, for example the IPortal on each invocation, are
+     * then a compare instead of a virtual call. The memo is written
+     * only once, thus objects that are cast to alternating types do not
+     * write their cacheline on every cast.
+     */
+    optional<void const*> cachedCast(TypeId id) const {
+      auto key = reinterpret_cast<uintptr_t>(id.debug());
+      auto memo = castMemo.load(std::memory_order_relaxed);
+      if (memo != 0 && (memo >> 16) == (key & 0xFFFFFFFFFFFFull)) {
+        return reinterpret_cast<char const*>(this) + int16_t(memo & 0xFFFF);
+      }
+      auto o = this->vcast(id);
+      if (!o) return o;
+      auto delta = reinterpret_cast<char const*>(*o) - reinterpret_cast<char const*>(this);
+      if (memo == 0 && (key >> 48) == 0xFFFF && delta == int16_t(delta)) {
+        castMemo.compare_exchange_strong(memo, (key << 16) | uint16_t(delta),
+                                         std::memory_order_relaxed);
+      }
+      return o;
+    }
+
+    mutable std::atomic<uintptr_t> castMemo = {0};
   };
 
 } // namespace mythos
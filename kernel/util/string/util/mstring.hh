@@ -26,24 +26,102 @@
 #pragma once
 
 #include <cstddef> // for size_t
+#include <cstdint>
 
 namespace mythos {
 
+  /** CPU features that select the implementation of the string
+   * operations. They are detected by a global constructor, hence
+   * calls before the initialisation of the globals use the generic
+   * implementation. All variants use general purpose registers only
+   * and, thus, do not touch the user's FPU state.
+   */
+  struct StringFeatures {
+    bool erms = false; //< enhanced rep movsb/stosb
+    bool fsrm = false; //< fast short rep movsb
+  };
+  extern StringFeatures stringFeatures;
+
+  /** copies small blocks with a few moves instead of a string instruction */
+  inline void memcpy_small(char* d, char const* s, size_t count) {
+    while (count >= 8) { __builtin_memcpy(d, s, 8); d += 8; s += 8; count -= 8; }
+    if (count >= 4) { __builtin_memcpy(d, s, 4); d += 4; s += 4; count -= 4; }
+    if (count >= 2) { __builtin_memcpy(d, s, 2); d += 2; s += 2; count -= 2; }
+    if (count) *d = *s;
+  }
+
   inline void* memcpy(void* dst, void const* src, size_t count) {
     auto d = reinterpret_cast<char*>(dst);
     auto s = reinterpret_cast<char const*>(src);
+#if defined(__x86_64__)
+    if (count < 32 && !stringFeatures.fsrm) {
+      memcpy_small(d, s, count);
+    } else if (stringFeatures.erms) {
+      asm volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(count) : : "memory");
+    } else {
+      size_t words = count / 8;
+      asm volatile("rep movsq" : "+D"(d), "+S"(s), "+c"(words) : : "memory");
+      memcpy_small(d, s, count % 8);
+    }
+#else
     for(size_t index = 0; index < count; index++){
       d[index] = s[index];
     }
+#endif
     return dst;
   }
 
   inline void* memset(void* dst, char value, size_t count) {
     auto d = reinterpret_cast<char*>(dst);
+#if defined(__x86_64__)
+    if (stringFeatures.erms) {
+      asm volatile("rep stosb" : "+D"(d), "+c"(count) : "a"(value) : "memory");
+    } else {
+      uint64_t pattern = uint64_t(uint8_t(value)) * 0x0101010101010101ull;
+      size_t words = count / 8;
+      asm volatile("rep stosq" : "+D"(d), "+c"(words) : "a"(pattern) : "memory");
+      for (size_t index = 0; index < count % 8; index++) d[index] = value;
+    }
+#else
     for(size_t index = 0; index < count; index++) d[index] = value;
+#endif
     return dst;
   }
 
+  /** Zeroes a large buffer with non-temporal stores that bypass the
+   * caches. Use this for page-sized and larger blocks that are not
+   * accessed again soon, for example zeroed memory that is put into a
+   * pool. Smaller blocks fall back to memset.
+   */
+  inline void* memzero_nt(void* dst, size_t count) {
+#if defined(__x86_64__)
+    auto d = reinterpret_cast<char*>(dst);
+    if (count < 4096) return memset(dst, 0, count);
+    auto head = (8 - (reinterpret_cast<uintptr_t>(d) & 7)) & 7;
+    memset(d, 0, head);
+    d += head;
+    count -= head;
+    auto p = reinterpret_cast<uint64_t*>(d);
+    uint64_t zero = 0;
+    for (size_t words = count / 64; words > 0; words--, p += 8) {
+      asm volatile("movnti %1, 0(%0)\n\t"
+                   "movnti %1, 8(%0)\n\t"
+                   "movnti %1, 16(%0)\n\t"
+                   "movnti %1, 24(%0)\n\t"
+                   "movnti %1, 32(%0)\n\t"
+                   "movnti %1, 40(%0)\n\t"
+                   "movnti %1, 48(%0)\n\t"
+                   "movnti %1, 56(%0)"
+                   : : "r"(p), "r"(zero) : "memory");
+    }
+    asm volatile("sfence" ::: "memory"); // order the weakly ordered stores
+    memset(p, 0, count % 64);
+    return dst;
+#else
+    return memset(dst, 0, count);
+#endif
+  }
+
   inline int strcmp(const char *s1, const char *s2)
   {
     while (*s1 && *s2 && *s1 == *s2) {
@@ -68,6 +146,18 @@ namespace mythos {
     auto p1 = reinterpret_cast<const unsigned char*>(ptr1);
     auto p2 = reinterpret_cast<const unsigned char*>(ptr2);
 
+#if defined(__x86_64__)
+    // compare word by word and find the first differing byte only at the end
+    for (; num >= 8; num -= 8, p1 += 8, p2 += 8) {
+      uint64_t w1, w2;
+      __builtin_memcpy(&w1, p1, 8);
+      __builtin_memcpy(&w2, p2, 8);
+      if (w1 != w2) {
+        // the lowest address is the most significant byte after the swap
+        return __builtin_bswap64(w1) < __builtin_bswap64(w2) ? -1 : 1;
+      }
+    }
+#endif
     for (size_t i=0; i<num; i++) {
       if (p1[i] != p2[i]) return p1[i] < p2[i] ? -1 : 1;
     }
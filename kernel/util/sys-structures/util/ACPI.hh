@@ -92,7 +92,7 @@ namespace mythos {
   public:
     uint8_t   apic_id;
     uint8_t   reserved__;
-    void*  apic_address;
+    uint32_t apic_address;
     uint32_t global_system_interrupt_base;
   };
 
@@ -70,24 +70,26 @@ ACPIApicTopology::ACPIApicTopology()
         break;
       }
       case APICEntry::IO_APIC: {
-        //IOAPICEntry* io_apic = (IOAPICEntry*) entry;
-        ioApic = (void*) entry;
-        MLOG_DETAIL(mlog::boot, "Found IOAPIC at", DVAR(entry));
-        // TODO should store the io-apic address!
-        // ioapic_id = io_apic->apic_id;
-        // unsigned int id = system_topology.ioapic_id << 4;
-        // addr_t ioapic_regs_addr = round_down(IO_APIC_REGISTERS_ADDRESS, align4K);
-        // mmapper->mmap(ioapic_regs_addr, ioapic_regs_addr, round_up(sizeof(int) * 2, align4K), IMemoryMapper::RWCD);
-        // (*((volatile unsigned int*) 0xfec00000)) = 0;
-        // (*((volatile unsigned int*) 0xfec00010)) = id;
+        IOAPICEntry* io_apic = static_cast<IOAPICEntry*>(entry);
+        MLOG_DETAIL(mlog::boot, "Found IOAPIC", DVAR(io_apic->apic_id),
+                    DVARhex(io_apic->apic_address), DVAR(io_apic->global_system_interrupt_base));
+        if (n_ioapics == IOAPIC_ENTRIES_MAX) break;
+        ioApics[n_ioapics] = io_apic->apic_address;
+        ioApicGSIs[n_ioapics] = io_apic->global_system_interrupt_base;
+        n_ioapics++;
         break;
       }
       case APICEntry::SOURCE_OVERRIDE: {
-        // TODO this looks too strange!
-        // SourceOverrideEntry* override = (SourceOverrideEntry*) entry;
-        // if(override->bus != 0) break;
-        // ioapic_irqs[override->global_system_interrupt] = override->source;
-        // ioapic_irqs[override->source]--;
+        SourceOverrideEntry* override = static_cast<SourceOverrideEntry*>(entry);
+        MLOG_DETAIL(mlog::boot, "Found interrupt source override", DVAR(override->bus),
+                    DVAR(override->source), DVAR(override->global_system_interrupt),
+                    DVARhex(override->flags));
+        if (override->bus != 0) break; // only ISA is defined
+        if (n_overrides == OVERRIDES_MAX) break;
+        overrides[n_overrides].source = override->source;
+        overrides[n_overrides].gsi = override->global_system_interrupt;
+        overrides[n_overrides].flags = override->flags;
+        n_overrides++;
         break;
       }
     } // switch
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 namespace mythos {
 
@@ -35,15 +36,29 @@ namespace mythos {
     ACPIApicTopology();
     size_t numThreads() const { return n_threads; }
     size_t threadID(size_t idx) const { return lapicIDs[idx]; }
-    void* ioApicBase() {return ioApic; }
+    size_t numIOApics() const { return n_ioapics; }
+    size_t ioApicBase(size_t idx) const { return ioApics[idx]; }
+    uint32_t ioApicGSIBase(size_t idx) const { return ioApicGSIs[idx]; }
+
+    /** ISA interrupt that is not identity mapped to a global system interrupt */
+    struct SourceOverride {
+      uint8_t source;
+      uint32_t gsi;
+      uint16_t flags; //< MPS INTI flags: polarity and trigger mode
+    };
+    size_t numSourceOverrides() const { return n_overrides; }
+    SourceOverride const& sourceOverride(size_t idx) const { return overrides[idx]; }
   protected:
     bool systemDetected;
     size_t n_threads;
-    enum { CPU_MAX=256 };
+    enum { CPU_MAX=256, IOAPIC_ENTRIES_MAX=8, OVERRIDES_MAX=16 };
     unsigned int lapicIDs[CPU_MAX];
-    void* ioApic = nullptr; // Just one ioapic supported at the time
+    size_t n_ioapics = 0;
+    size_t ioApics[IOAPIC_ENTRIES_MAX]; // physical addresses in the order of the MADT
+    uint32_t ioApicGSIs[IOAPIC_ENTRIES_MAX]; // global system interrupt of the first entry
+    size_t n_overrides = 0;
+    SourceOverride overrides[OVERRIDES_MAX];
     bool disablePICs;
-    //char ioapic_irqs[24]; // TODO randolf does not understand the init code
   };
 
 } // namespace mythos
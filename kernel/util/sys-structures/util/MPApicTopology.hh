@@ -171,7 +171,7 @@ namespace mythos {
           }
           case IOAPIC: {
             auto *apic = static_cast<IntelMP::EntryIOApic*>(entry);
-            ioapic = apic->address;
+            if (num_ioapics < IOAPIC_ENTRIES_MAX) ioapics[num_ioapics++] = apic->address;
             MLOG_DETAIL(mlog::boot, "IOAPIC at", DVAR(apic->id), DVAR(apic->version), DVAR(apic->flags), DVARhex(apic->address));
             pos+=8;
             entry_count++;
@@ -189,7 +189,8 @@ namespace mythos {
     size_t numThreads() const { return num_threads; }
     size_t threadID(size_t idx) const { return lapicIDs[idx]; }
 
-    size_t ioapic_address() {return ioapic; };
+    size_t numIOApics() const { return num_ioapics; }
+    size_t ioapic_address(size_t idx) const { return ioapics[idx]; }
 
   protected:
 
@@ -233,9 +234,10 @@ namespace mythos {
       PCMP=0x504D4350 // hex for "PCMP"
     };
 
-    enum{ CPU_MAX=256};
+    enum{ CPU_MAX=256, IOAPIC_ENTRIES_MAX=8 };
     size_t num_threads;
     unsigned int lapicIDs[CPU_MAX];
-    size_t ioapic {0};
+    size_t num_ioapics {0};
+    size_t ioapics[IOAPIC_ENTRIES_MAX];
   };
 }